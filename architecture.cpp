@@ -20,7 +20,9 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 #include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
+#include <algorithm>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
@@ -46,6 +48,434 @@ void InstructionInfo::AddBranch(BNBranchType type, uint64_t target, Architecture
 }
 
 
+void InstructionInfoBatch::Clear()
+{
+	addresses.clear();
+	info.clear();
+}
+
+
+void InstructionTextBatch::Clear()
+{
+	addresses.clear();
+	lengths.clear();
+	tokenStart.clear();
+	tokens.clear();
+}
+
+
+void InstructionDecodeCache::Invalidator::OnBinaryDataWritten(BinaryView*, uint64_t offset, size_t len)
+{
+	m_cache->Invalidate(offset, len);
+}
+
+
+void InstructionDecodeCache::Invalidator::OnBinaryDataInserted(BinaryView*, uint64_t offset, size_t)
+{
+	// Everything after the insertion point has moved
+	m_cache->Invalidate(offset, (uint64_t)-1 - offset);
+}
+
+
+void InstructionDecodeCache::Invalidator::OnBinaryDataRemoved(BinaryView*, uint64_t offset, uint64_t)
+{
+	m_cache->Invalidate(offset, (uint64_t)-1 - offset);
+}
+
+
+InstructionDecodeCache::InstructionDecodeCache(size_t maxInstructionLength, size_t maxEntries):
+	m_shardCapacity(1), m_maxInstructionLength(maxInstructionLength), m_hits(0), m_misses(0)
+{
+	if (m_maxInstructionLength == 0)
+		m_maxInstructionLength = 1;
+	SetCapacity(maxEntries);
+}
+
+
+void InstructionDecodeCache::SetCapacity(size_t maxEntries)
+{
+	size_t shardCapacity = (maxEntries + ShardCount - 1) / ShardCount;
+	if (shardCapacity == 0)
+		shardCapacity = 1;
+	m_shardCapacity = shardCapacity;
+
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		while (shard.entries.size() > shardCapacity)
+		{
+			shard.index.erase(shard.entries.back().key);
+			shard.entries.pop_back();
+		}
+	}
+}
+
+
+size_t InstructionDecodeCache::GetCapacity() const
+{
+	return m_shardCapacity * ShardCount;
+}
+
+
+size_t InstructionDecodeCache::GetEntryCount()
+{
+	size_t count = 0;
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		count += shard.entries.size();
+	}
+	return count;
+}
+
+
+InstructionDecodeCache::Key InstructionDecodeCache::GetKey(const uint8_t* data, uint64_t addr, size_t len) const
+{
+	// Decoders never look past the maximum instruction length, so only those bytes identify the result
+	Key key;
+	key.address = addr;
+	key.length = (len < m_maxInstructionLength) ? len : m_maxInstructionLength;
+
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < key.length; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	key.hash = hash;
+	return key;
+}
+
+
+InstructionDecodeCache::Shard& InstructionDecodeCache::GetShard(const Key& key)
+{
+	return m_shards[(size_t)(key.hash ^ (key.hash >> 32) ^ key.address) % ShardCount];
+}
+
+
+InstructionDecodeCache::Entry* InstructionDecodeCache::Find(Shard& shard, const Key& key, const uint8_t* data)
+{
+	auto i = shard.index.find(key);
+	if (i == shard.index.end())
+		return nullptr;
+
+	Entry& entry = *i->second;
+	if ((key.length != 0) && (memcmp(&entry.bytes[0], data, key.length) != 0))
+		return nullptr;
+
+	shard.entries.splice(shard.entries.begin(), shard.entries, i->second);
+	return &entry;
+}
+
+
+InstructionDecodeCache::Entry& InstructionDecodeCache::Insert(Shard& shard, const Key& key, const uint8_t* data)
+{
+	auto i = shard.index.find(key);
+	if (i != shard.index.end())
+	{
+		shard.entries.splice(shard.entries.begin(), shard.entries, i->second);
+		if ((key.length == 0) || (memcmp(&i->second->bytes[0], data, key.length) == 0))
+			return *i->second;
+	}
+	else
+	{
+		size_t capacity = m_shardCapacity;
+		while (shard.entries.size() >= capacity)
+		{
+			shard.index.erase(shard.entries.back().key);
+			shard.entries.pop_back();
+		}
+		shard.entries.emplace_front();
+		shard.index[key] = shard.entries.begin();
+	}
+
+	// New entry, or a hash collision that replaces the previous bytes
+	Entry& entry = shard.entries.front();
+	entry.key = key;
+	entry.bytes.assign(data, data + key.length);
+	entry.hasInfo = false;
+	entry.infoValid = false;
+	entry.hasText = false;
+	entry.textValid = false;
+	entry.textLength = 0;
+	entry.text.clear();
+	return entry;
+}
+
+
+bool InstructionDecodeCache::LookupInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen,
+	InstructionInfo& result, bool& ok)
+{
+	Key key = GetKey(data, addr, maxLen);
+	Shard& shard = GetShard(key);
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		Entry* entry = Find(shard, key, data);
+		if (entry && entry->hasInfo)
+		{
+			result = entry->info;
+			ok = entry->infoValid;
+			m_hits++;
+			return true;
+		}
+	}
+	m_misses++;
+	return false;
+}
+
+
+void InstructionDecodeCache::StoreInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen,
+	const InstructionInfo& result, bool ok)
+{
+	Key key = GetKey(data, addr, maxLen);
+	Shard& shard = GetShard(key);
+	unique_lock<mutex> lock(shard.mutex);
+	Entry& entry = Insert(shard, key, data);
+	entry.hasInfo = true;
+	entry.infoValid = ok;
+	entry.info = result;
+}
+
+
+bool InstructionDecodeCache::LookupInstructionText(const uint8_t* data, uint64_t addr, size_t& len,
+	vector<InstructionTextToken>& result, bool& ok)
+{
+	Key key = GetKey(data, addr, len);
+	Shard& shard = GetShard(key);
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		Entry* entry = Find(shard, key, data);
+		if (entry && entry->hasText)
+		{
+			result.insert(result.end(), entry->text.begin(), entry->text.end());
+			len = entry->textLength;
+			ok = entry->textValid;
+			m_hits++;
+			return true;
+		}
+	}
+	m_misses++;
+	return false;
+}
+
+
+void InstructionDecodeCache::StoreInstructionText(const uint8_t* data, uint64_t addr, size_t maxLen, size_t len,
+	const vector<InstructionTextToken>& result, bool ok)
+{
+	Key key = GetKey(data, addr, maxLen);
+	Shard& shard = GetShard(key);
+	unique_lock<mutex> lock(shard.mutex);
+	Entry& entry = Insert(shard, key, data);
+	entry.hasText = true;
+	entry.textValid = ok;
+	entry.textLength = len;
+	entry.text = result;
+}
+
+
+void InstructionDecodeCache::Invalidate()
+{
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		shard.index.clear();
+		shard.entries.clear();
+	}
+}
+
+
+void InstructionDecodeCache::Invalidate(uint64_t start, uint64_t len)
+{
+	uint64_t end = (len > ((uint64_t)-1 - start)) ? (uint64_t)-1 : (start + len);
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		for (auto i = shard.entries.begin(); i != shard.entries.end(); )
+		{
+			if ((i->key.address < end) && ((i->key.address + i->key.length) > start))
+			{
+				shard.index.erase(i->key);
+				i = shard.entries.erase(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+}
+
+
+void InstructionDecodeCache::ResetCounters()
+{
+	m_hits = 0;
+	m_misses = 0;
+}
+
+
+template <class T>
+static const T* FindMetadataEntry(const vector<T>& entries, uint32_t id)
+{
+	auto i = lower_bound(entries.begin(), entries.end(), id,
+		[](const T& entry, uint32_t value) { return entry.id < value; });
+	if ((i == entries.end()) || (i->id != id))
+		return nullptr;
+	return &*i;
+}
+
+
+template <class T>
+static void SortMetadataEntries(vector<T>& entries)
+{
+	stable_sort(entries.begin(), entries.end(), [](const T& a, const T& b) { return a.id < b.id; });
+}
+
+
+ArchitectureMetadataTable::ArchitectureMetadataTable(): m_hasRegisters(false), m_hasFlags(false),
+	m_hasFlagWriteTypes(false), m_hasFlagConditions(false)
+{
+	ListRef empty;
+	empty.offset = 0;
+	empty.count = 0;
+	for (auto& i : m_flagConditionLists)
+		i = empty;
+	m_allRegisters = empty;
+	m_fullWidthRegisters = empty;
+	m_globalRegisters = empty;
+	m_allFlags = empty;
+	m_allFlagWriteTypes = empty;
+	m_lists.push_back(0);
+}
+
+
+ArchitectureMetadataTable::ListRef ArchitectureMetadataTable::AddList(const uint32_t* values, size_t count)
+{
+	ListRef result;
+	result.offset = (count == 0) ? 0 : m_lists.size();
+	result.count = count;
+	m_lists.insert(m_lists.end(), values, values + count);
+	return result;
+}
+
+
+const uint32_t* ArchitectureMetadataTable::GetList(const ListRef& list, size_t& count) const
+{
+	count = list.count;
+	return &m_lists[list.offset];
+}
+
+
+void ArchitectureMetadataTable::SetRegisters(const ArchitectureRegisterEntry* regs, size_t count)
+{
+	vector<uint32_t> all, fullWidth, global;
+	for (size_t i = 0; i < count; i++)
+	{
+		all.push_back(regs[i].id);
+		if (regs[i].fullWidthRegister == regs[i].id)
+			fullWidth.push_back(regs[i].id);
+		if (regs[i].global)
+			global.push_back(regs[i].id);
+	}
+
+	m_registers.assign(regs, regs + count);
+	SortMetadataEntries(m_registers);
+	m_allRegisters = AddList(all.data(), all.size());
+	m_fullWidthRegisters = AddList(fullWidth.data(), fullWidth.size());
+	m_globalRegisters = AddList(global.data(), global.size());
+	m_hasRegisters = true;
+}
+
+
+void ArchitectureMetadataTable::SetFlags(const ArchitectureFlagEntry* flags, size_t count)
+{
+	vector<uint32_t> all;
+	for (size_t i = 0; i < count; i++)
+		all.push_back(flags[i].id);
+
+	m_flags.assign(flags, flags + count);
+	SortMetadataEntries(m_flags);
+	m_allFlags = AddList(all.data(), all.size());
+	m_hasFlags = true;
+}
+
+
+void ArchitectureMetadataTable::SetFlagWriteTypes(const ArchitectureFlagWriteTypeEntry* writeTypes, size_t count)
+{
+	vector<uint32_t> all;
+	for (size_t i = 0; i < count; i++)
+		all.push_back(writeTypes[i].id);
+
+	m_flagWriteTypes.assign(writeTypes, writeTypes + count);
+	SortMetadataEntries(m_flagWriteTypes);
+	m_flagWriteTypeLists.clear();
+	for (auto& i : m_flagWriteTypes)
+		m_flagWriteTypeLists.push_back(AddList(i.flags, i.flagCount));
+	m_allFlagWriteTypes = AddList(all.data(), all.size());
+	m_hasFlagWriteTypes = true;
+}
+
+
+void ArchitectureMetadataTable::SetFlagConditions(const ArchitectureFlagConditionEntry* conditions, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if ((size_t)conditions[i].condition > (size_t)LLFC_NO)
+			continue;
+		m_flagConditionLists[conditions[i].condition] = AddList(conditions[i].flags, conditions[i].flagCount);
+	}
+	m_hasFlagConditions = true;
+}
+
+
+const ArchitectureRegisterEntry* ArchitectureMetadataTable::GetRegister(uint32_t reg) const
+{
+	return FindMetadataEntry(m_registers, reg);
+}
+
+
+const ArchitectureFlagEntry* ArchitectureMetadataTable::GetFlag(uint32_t flag) const
+{
+	return FindMetadataEntry(m_flags, flag);
+}
+
+
+const ArchitectureFlagWriteTypeEntry* ArchitectureMetadataTable::GetFlagWriteType(uint32_t writeType) const
+{
+	return FindMetadataEntry(m_flagWriteTypes, writeType);
+}
+
+
+const uint32_t* ArchitectureMetadataTable::GetFlagsRequiredForFlagCondition(BNLowLevelILFlagCondition cond,
+	size_t& count) const
+{
+	if ((size_t)cond > (size_t)LLFC_NO)
+	{
+		count = 0;
+		return &m_lists[0];
+	}
+	return GetList(m_flagConditionLists[cond], count);
+}
+
+
+const uint32_t* ArchitectureMetadataTable::GetFlagsWrittenByFlagWriteType(uint32_t writeType, size_t& count) const
+{
+	const ArchitectureFlagWriteTypeEntry* entry = FindMetadataEntry(m_flagWriteTypes, writeType);
+	if (!entry)
+	{
+		count = 0;
+		return &m_lists[0];
+	}
+	return GetList(m_flagWriteTypeLists[entry - m_flagWriteTypes.data()], count);
+}
+
+
+bool ArchitectureMetadataTable::IsTableList(const uint32_t* list) const
+{
+	return (list >= m_lists.data()) && (list < (m_lists.data() + m_lists.size()));
+}
+
+
 InstructionTextToken::InstructionTextToken(): type(TextToken), value(0), confidence(BN_FULL_CONFIDENCE)
 {
 }
@@ -71,13 +501,63 @@ InstructionTextToken InstructionTextToken::WithConfidence(uint8_t conf)
 }
 
 
-Architecture::Architecture(BNArchitecture* arch)
+vector<InstructionTextToken> InstructionTextToken::ConvertInstructionTextTokenList(
+	const BNInstructionTextToken* tokens, size_t count)
+{
+	vector<InstructionTextToken> result;
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		result.push_back(InstructionTextToken(tokens[i].type, tokens[i].context, tokens[i].text, tokens[i].address,
+			tokens[i].value, tokens[i].size, tokens[i].operand, tokens[i].confidence));
+	}
+	return result;
+}
+
+
+BNInstructionTextToken* InstructionTextToken::CreateInstructionTextTokenList(const vector<InstructionTextToken>& tokens)
+{
+	// The token structures and all of their text are placed in a single allocation, so that the whole list
+	// can be released at once with FreeInstructionTextTokenList instead of freeing each string
+	size_t textSize = 0;
+	for (auto& i : tokens)
+		textSize += i.text.size() + 1;
+
+	uint8_t* block = new uint8_t[(sizeof(BNInstructionTextToken) * tokens.size()) + textSize];
+	BNInstructionTextToken* result = (BNInstructionTextToken*)block;
+	char* text = (char*)(result + tokens.size());
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		size_t len = tokens[i].text.size() + 1;
+		memcpy(text, tokens[i].text.c_str(), len);
+		result[i].type = tokens[i].type;
+		result[i].text = text;
+		result[i].value = tokens[i].value;
+		result[i].size = tokens[i].size;
+		result[i].operand = tokens[i].operand;
+		result[i].context = tokens[i].context;
+		result[i].confidence = tokens[i].confidence;
+		result[i].address = tokens[i].address;
+		text += len;
+	}
+	return result;
+}
+
+
+void InstructionTextToken::FreeInstructionTextTokenList(BNInstructionTextToken* tokens)
+{
+	delete[] (uint8_t*)tokens;
+}
+
+
+Architecture::Architecture(BNArchitecture* arch): m_decodeCache(nullptr), m_liftCache(nullptr)
 {
 	m_object = arch;
 }
 
 
-Architecture::Architecture(const string& name): m_nameForRegister(name)
+Architecture::Architecture(const string& name): m_nameForRegister(name), m_decodeCache(nullptr),
+	m_liftCache(nullptr)
 {
 	m_object = nullptr;
 }
@@ -136,9 +616,8 @@ bool Architecture::GetInstructionInfoCallback(void* ctxt, const uint8_t* data, u
                                               size_t maxLen, BNInstructionInfo* result)
 {
 	Architecture* arch = (Architecture*)ctxt;
-
 	InstructionInfo info;
-	bool ok = arch->GetInstructionInfo(data, addr, maxLen, info);
+	bool ok = arch->GetCachedInstructionInfo(data, addr, maxLen, info);
 	*result = info;
 	return ok;
 }
@@ -150,7 +629,18 @@ bool Architecture::GetInstructionTextCallback(void* ctxt, const uint8_t* data, u
 	Architecture* arch = (Architecture*)ctxt;
 
 	vector<InstructionTextToken> tokens;
-	bool ok = arch->GetInstructionText(data, addr, *len, tokens);
+	bool ok;
+	InstructionDecodeCache* cache = arch->m_decodeCache;
+	if ((!cache) || (!cache->LookupInstructionText(data, addr, *len, tokens, ok)))
+	{
+		unique_lock<recursive_mutex> lock(arch->m_callbackMutex, defer_lock);
+		if (arch->RequiresSerializedCallbacks())
+			lock.lock();
+		size_t maxLen = *len;
+		ok = arch->GetInstructionText(data, addr, *len, tokens);
+		if (cache)
+			cache->StoreInstructionText(data, addr, maxLen, *len, tokens, ok);
+	}
 	if (!ok)
 	{
 		*result = nullptr;
@@ -159,27 +649,14 @@ bool Architecture::GetInstructionTextCallback(void* ctxt, const uint8_t* data, u
 	}
 
 	*count = tokens.size();
-	*result = new BNInstructionTextToken[tokens.size()];
-	for (size_t i = 0; i < tokens.size(); i++)
-	{
-		(*result)[i].type = tokens[i].type;
-		(*result)[i].text = BNAllocString(tokens[i].text.c_str());
-		(*result)[i].value = tokens[i].value;
-		(*result)[i].size = tokens[i].size;
-		(*result)[i].operand = tokens[i].operand;
-		(*result)[i].context = tokens[i].context;
-		(*result)[i].confidence = tokens[i].confidence;
-		(*result)[i].address = tokens[i].address;
-	}
+	*result = InstructionTextToken::CreateInstructionTextTokenList(tokens);
 	return true;
 }
 
 
-void Architecture::FreeInstructionTextCallback(BNInstructionTextToken* tokens, size_t count)
+void Architecture::FreeInstructionTextCallback(BNInstructionTextToken* tokens, size_t)
 {
-	for (size_t i = 0; i < count; i++)
-		BNFreeString(tokens[i].text);
-	delete[] tokens;
+	InstructionTextToken::FreeInstructionTextTokenList(tokens);
 }
 
 
@@ -187,7 +664,13 @@ bool Architecture::GetInstructionLowLevelILCallback(void* ctxt, const uint8_t* d
                                                     size_t* len, BNLowLevelILFunction* il)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	unique_lock<recursive_mutex> lock(arch->m_callbackMutex, defer_lock);
+	if (arch->RequiresSerializedCallbacks())
+		lock.lock();
 	LowLevelILFunction func(il);
+	LowLevelILLiftCache* cache = arch->m_liftCache;
+	if (cache)
+		return cache->GetInstructionLowLevelIL(arch, data, addr, *len, func);
 	return arch->GetInstructionLowLevelIL(data, addr, *len, func);
 }
 
@@ -195,6 +678,9 @@ bool Architecture::GetInstructionLowLevelILCallback(void* ctxt, const uint8_t* d
 char* Architecture::GetRegisterNameCallback(void* ctxt, uint32_t reg)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	const ArchitectureRegisterEntry* entry = arch->m_metadata.GetRegister(reg);
+	if (entry)
+		return BNAllocString(entry->name);
 	string result = arch->GetRegisterName(reg);
 	return BNAllocString(result.c_str());
 }
@@ -203,6 +689,9 @@ char* Architecture::GetRegisterNameCallback(void* ctxt, uint32_t reg)
 char* Architecture::GetFlagNameCallback(void* ctxt, uint32_t flag)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	const ArchitectureFlagEntry* entry = arch->m_metadata.GetFlag(flag);
+	if (entry)
+		return BNAllocString(entry->name);
 	string result = arch->GetFlagName(flag);
 	return BNAllocString(result.c_str());
 }
@@ -211,6 +700,9 @@ char* Architecture::GetFlagNameCallback(void* ctxt, uint32_t flag)
 char* Architecture::GetFlagWriteTypeNameCallback(void* ctxt, uint32_t flags)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	const ArchitectureFlagWriteTypeEntry* entry = arch->m_metadata.GetFlagWriteType(flags);
+	if (entry)
+		return BNAllocString(entry->name);
 	string result = arch->GetFlagWriteTypeName(flags);
 	return BNAllocString(result.c_str());
 }
@@ -219,6 +711,9 @@ char* Architecture::GetFlagWriteTypeNameCallback(void* ctxt, uint32_t flags)
 uint32_t* Architecture::GetFullWidthRegistersCallback(void* ctxt, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasRegisters())
+		return (uint32_t*)arch->m_metadata.GetFullWidthRegisters(*count);
+
 	vector<uint32_t> regs = arch->GetFullWidthRegisters();
 	*count = regs.size();
 
@@ -232,6 +727,9 @@ uint32_t* Architecture::GetFullWidthRegistersCallback(void* ctxt, size_t* count)
 uint32_t* Architecture::GetAllRegistersCallback(void* ctxt, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasRegisters())
+		return (uint32_t*)arch->m_metadata.GetAllRegisters(*count);
+
 	vector<uint32_t> regs = arch->GetAllRegisters();
 	*count = regs.size();
 
@@ -245,6 +743,9 @@ uint32_t* Architecture::GetAllRegistersCallback(void* ctxt, size_t* count)
 uint32_t* Architecture::GetAllFlagsCallback(void* ctxt, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasFlags())
+		return (uint32_t*)arch->m_metadata.GetAllFlags(*count);
+
 	vector<uint32_t> regs = arch->GetAllFlags();
 	*count = regs.size();
 
@@ -258,6 +759,9 @@ uint32_t* Architecture::GetAllFlagsCallback(void* ctxt, size_t* count)
 uint32_t* Architecture::GetAllFlagWriteTypesCallback(void* ctxt, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasFlagWriteTypes())
+		return (uint32_t*)arch->m_metadata.GetAllFlagWriteTypes(*count);
+
 	vector<uint32_t> regs = arch->GetAllFlagWriteTypes();
 	*count = regs.size();
 
@@ -271,6 +775,9 @@ uint32_t* Architecture::GetAllFlagWriteTypesCallback(void* ctxt, size_t* count)
 BNFlagRole Architecture::GetFlagRoleCallback(void* ctxt, uint32_t flag)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	const ArchitectureFlagEntry* entry = arch->m_metadata.GetFlag(flag);
+	if (entry)
+		return entry->role;
 	return arch->GetFlagRole(flag);
 }
 
@@ -278,6 +785,9 @@ BNFlagRole Architecture::GetFlagRoleCallback(void* ctxt, uint32_t flag)
 uint32_t* Architecture::GetFlagsRequiredForFlagConditionCallback(void* ctxt, BNLowLevelILFlagCondition cond, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasFlagConditions())
+		return (uint32_t*)arch->m_metadata.GetFlagsRequiredForFlagCondition(cond, *count);
+
 	vector<uint32_t> flags = arch->GetFlagsRequiredForFlagCondition(cond);
 	*count = flags.size();
 
@@ -291,6 +801,9 @@ uint32_t* Architecture::GetFlagsRequiredForFlagConditionCallback(void* ctxt, BNL
 uint32_t* Architecture::GetFlagsWrittenByFlagWriteTypeCallback(void* ctxt, uint32_t writeType, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasFlagWriteTypes())
+		return (uint32_t*)arch->m_metadata.GetFlagsWrittenByFlagWriteType(writeType, *count);
+
 	vector<uint32_t> flags = arch->GetFlagsWrittenByFlagWriteType(writeType);
 	*count = flags.size();
 
@@ -305,6 +818,9 @@ size_t Architecture::GetFlagWriteLowLevelILCallback(void* ctxt, BNLowLevelILOper
 	uint32_t flag, BNRegisterOrConstant* operands, size_t operandCount, BNLowLevelILFunction* il)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	unique_lock<recursive_mutex> lock(arch->m_callbackMutex, defer_lock);
+	if (arch->RequiresSerializedCallbacks())
+		lock.lock();
 	LowLevelILFunction func(il);
 	return arch->GetFlagWriteLowLevelIL(op, size, flagWriteType, flag, operands, operandCount, func);
 }
@@ -314,13 +830,20 @@ size_t Architecture::GetFlagConditionLowLevelILCallback(void* ctxt, BNLowLevelIL
 	BNLowLevelILFunction* il)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	unique_lock<recursive_mutex> lock(arch->m_callbackMutex, defer_lock);
+	if (arch->RequiresSerializedCallbacks())
+		lock.lock();
 	LowLevelILFunction func(il);
 	return arch->GetFlagConditionLowLevelIL(cond, func);
 }
 
 
-void Architecture::FreeRegisterListCallback(void*, uint32_t* regs)
+void Architecture::FreeRegisterListCallback(void* ctxt, uint32_t* regs)
 {
+	// Lists served from the metadata table are owned by it
+	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.IsTableList(regs))
+		return;
 	delete[] regs;
 }
 
@@ -328,6 +851,15 @@ void Architecture::FreeRegisterListCallback(void*, uint32_t* regs)
 void Architecture::GetRegisterInfoCallback(void* ctxt, uint32_t reg, BNRegisterInfo* result)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	const ArchitectureRegisterEntry* entry = arch->m_metadata.GetRegister(reg);
+	if (entry)
+	{
+		result->fullWidthRegister = entry->fullWidthRegister;
+		result->offset = entry->offset;
+		result->size = entry->size;
+		result->extend = entry->extend;
+		return;
+	}
 	*result = arch->GetRegisterInfo(reg);
 }
 
@@ -349,6 +881,9 @@ uint32_t Architecture::GetLinkRegisterCallback(void* ctxt)
 uint32_t* Architecture::GetGlobalRegistersCallback(void* ctxt, size_t* count)
 {
 	Architecture* arch = (Architecture*)ctxt;
+	if (arch->m_metadata.HasRegisters())
+		return (uint32_t*)arch->m_metadata.GetGlobalRegisters(*count);
+
 	vector<uint32_t> regs = arch->GetGlobalRegisters();
 	*count = regs.size();
 
@@ -544,6 +1079,155 @@ Ref<Architecture> Architecture::GetAssociatedArchitectureByAddress(uint64_t&)
 }
 
 
+void Architecture::EnableDecodeCache(size_t maxEntries)
+{
+	unique_lock<mutex> lock(m_cacheMutex);
+	// The cache object is never freed while the architecture is alive, as decoders on other threads may
+	// still be using it after it has been disabled
+	if (m_decodeCacheStorage)
+		m_decodeCacheStorage->SetCapacity(maxEntries);
+	else
+		m_decodeCacheStorage.reset(new InstructionDecodeCache(GetMaxInstructionLength(), maxEntries));
+	m_decodeCache = m_decodeCacheStorage.get();
+}
+
+
+void Architecture::DisableDecodeCache()
+{
+	unique_lock<mutex> lock(m_cacheMutex);
+	m_decodeCache = nullptr;
+	if (m_decodeCacheStorage)
+		m_decodeCacheStorage->Invalidate();
+}
+
+
+void Architecture::EnableLiftingCache(size_t maxEntries, uint64_t granularity)
+{
+	unique_lock<mutex> lock(m_cacheMutex);
+	if (m_liftCacheStorage)
+		m_liftCacheStorage->SetCapacity(maxEntries);
+	else
+		m_liftCacheStorage.reset(new LowLevelILLiftCache(GetMaxInstructionLength(), GetAddressSize(), maxEntries,
+			granularity));
+	m_liftCache = m_liftCacheStorage.get();
+}
+
+
+void Architecture::DisableLiftingCache()
+{
+	unique_lock<mutex> lock(m_cacheMutex);
+	m_liftCache = nullptr;
+	if (m_liftCacheStorage)
+		m_liftCacheStorage->Invalidate();
+}
+
+
+bool Architecture::GetCachedInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen,
+	InstructionInfo& result)
+{
+	bool ok;
+	InstructionDecodeCache* cache = m_decodeCache;
+	if (cache && cache->LookupInstructionInfo(data, addr, maxLen, result, ok))
+		return ok;
+
+	unique_lock<recursive_mutex> lock(m_callbackMutex, defer_lock);
+	if (RequiresSerializedCallbacks())
+		lock.lock();
+	ok = GetInstructionInfo(data, addr, maxLen, result);
+	if (cache)
+		cache->StoreInstructionInfo(data, addr, maxLen, result, ok);
+	return ok;
+}
+
+
+bool Architecture::RequiresSerializedCallbacks() const
+{
+	return false;
+}
+
+
+Ref<LowLevelILFunction> Architecture::GetScratchLowLevelILFunction()
+{
+	// The core cannot clear an IL function, so the scratch function is replaced once it has grown
+	static const size_t maxScratchExprs = 4096;
+
+	// Each thread holds a token while it runs, which tells the entries of exited threads apart from a new
+	// thread that was given the same id
+	static thread_local shared_ptr<char> threadToken = make_shared<char>(0);
+
+	unique_lock<mutex> lock(m_scratchMutex);
+	auto i = m_scratchFunctions.find(this_thread::get_id());
+	if ((i == m_scratchFunctions.end()) || (i->second.thread.lock() != threadToken))
+	{
+		for (auto j = m_scratchFunctions.begin(); j != m_scratchFunctions.end(); )
+		{
+			if (j->second.thread.expired())
+				j = m_scratchFunctions.erase(j);
+			else
+				++j;
+		}
+
+		ScratchFunction& entry = m_scratchFunctions[this_thread::get_id()];
+		entry.thread = threadToken;
+		entry.func = new LowLevelILFunction(this);
+		return entry.func;
+	}
+
+	if (i->second.func->GetExprCount() >= maxScratchExprs)
+		i->second.func = new LowLevelILFunction(this);
+	return i->second.func;
+}
+
+
+size_t Architecture::GetInstructionInfoBatch(const uint8_t* data, uint64_t addr, size_t len,
+	InstructionInfoBatch& result, size_t maxCount)
+{
+	result.Clear();
+
+	size_t offset = 0;
+	InstructionInfo info;
+	while ((offset < len) && (result.GetCount() < maxCount))
+	{
+		info = InstructionInfo();
+		if (!GetInstructionInfo(data + offset, addr + offset, len - offset, info))
+			break;
+		if ((info.length == 0) || (info.length > (len - offset)))
+			break;
+		result.addresses.push_back(addr + offset);
+		result.info.push_back(info);
+		offset += info.length;
+	}
+	return result.GetCount();
+}
+
+
+size_t Architecture::GetInstructionTextBatch(const uint8_t* data, uint64_t addr, size_t len,
+	InstructionTextBatch& result, size_t maxCount)
+{
+	result.Clear();
+	result.tokenStart.push_back(0);
+
+	size_t offset = 0;
+	vector<InstructionTextToken> tokens;
+	while ((offset < len) && (result.GetCount() < maxCount))
+	{
+		size_t instrLen = len - offset;
+		tokens.clear();
+		if (!GetInstructionText(data + offset, addr + offset, instrLen, tokens))
+			break;
+		if ((instrLen == 0) || (instrLen > (len - offset)))
+			break;
+		result.addresses.push_back(addr + offset);
+		result.lengths.push_back(instrLen);
+		for (auto& i : tokens)
+			result.tokens.push_back(move(i));
+		result.tokenStart.push_back(result.tokens.size());
+		offset += instrLen;
+	}
+	return result.GetCount();
+}
+
+
 bool Architecture::GetInstructionLowLevelIL(const uint8_t*, uint64_t, size_t&, LowLevelILFunction& il)
 {
 	il.AddInstruction(il.Undefined());
@@ -553,6 +1237,10 @@ bool Architecture::GetInstructionLowLevelIL(const uint8_t*, uint64_t, size_t&, L
 
 string Architecture::GetRegisterName(uint32_t reg)
 {
+	const ArchitectureRegisterEntry* entry = m_metadata.GetRegister(reg);
+	if (entry)
+		return entry->name;
+
 	char regStr[32];
 	sprintf(regStr, "r%" PRIu32, reg);
 	return regStr;
@@ -561,6 +1249,10 @@ string Architecture::GetRegisterName(uint32_t reg)
 
 string Architecture::GetFlagName(uint32_t flag)
 {
+	const ArchitectureFlagEntry* entry = m_metadata.GetFlag(flag);
+	if (entry)
+		return entry->name;
+
 	char flagStr[32];
 	sprintf(flagStr, "flag%" PRIu32, flag);
 	return flagStr;
@@ -569,6 +1261,10 @@ string Architecture::GetFlagName(uint32_t flag)
 
 string Architecture::GetFlagWriteTypeName(uint32_t flags)
 {
+	const ArchitectureFlagWriteTypeEntry* entry = m_metadata.GetFlagWriteType(flags);
+	if (entry)
+		return entry->name;
+
 	char flagStr[32];
 	sprintf(flagStr, "update%" PRIu32, flags);
 	return flagStr;
@@ -577,43 +1273,58 @@ string Architecture::GetFlagWriteTypeName(uint32_t flags)
 
 vector<uint32_t> Architecture::GetFullWidthRegisters()
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetFullWidthRegisters(count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
 vector<uint32_t> Architecture::GetAllRegisters()
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetAllRegisters(count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
 vector<uint32_t> Architecture::GetAllFlags()
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetAllFlags(count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
 vector<uint32_t> Architecture::GetAllFlagWriteTypes()
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetAllFlagWriteTypes(count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
-BNFlagRole Architecture::GetFlagRole(uint32_t)
+BNFlagRole Architecture::GetFlagRole(uint32_t flag)
 {
+	const ArchitectureFlagEntry* entry = m_metadata.GetFlag(flag);
+	if (entry)
+		return entry->role;
 	return SpecialFlagRole;
 }
 
 
-vector<uint32_t> Architecture::GetFlagsRequiredForFlagCondition(BNLowLevelILFlagCondition)
+vector<uint32_t> Architecture::GetFlagsRequiredForFlagCondition(BNLowLevelILFlagCondition cond)
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetFlagsRequiredForFlagCondition(cond, count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
-vector<uint32_t> Architecture::GetFlagsWrittenByFlagWriteType(uint32_t)
+vector<uint32_t> Architecture::GetFlagsWrittenByFlagWriteType(uint32_t writeType)
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetFlagsWrittenByFlagWriteType(writeType, count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
@@ -647,9 +1358,19 @@ ExprId Architecture::GetDefaultFlagConditionLowLevelIL(BNLowLevelILFlagCondition
 }
 
 
-BNRegisterInfo Architecture::GetRegisterInfo(uint32_t)
+BNRegisterInfo Architecture::GetRegisterInfo(uint32_t reg)
 {
 	BNRegisterInfo result;
+	const ArchitectureRegisterEntry* entry = m_metadata.GetRegister(reg);
+	if (entry)
+	{
+		result.fullWidthRegister = entry->fullWidthRegister;
+		result.offset = entry->offset;
+		result.size = entry->size;
+		result.extend = entry->extend;
+		return result;
+	}
+
 	result.fullWidthRegister = 0;
 	result.offset = 0;
 	result.size = 0;
@@ -672,7 +1393,9 @@ uint32_t Architecture::GetLinkRegister()
 
 vector<uint32_t> Architecture::GetGlobalRegisters()
 {
-	return vector<uint32_t>();
+	size_t count;
+	const uint32_t* list = m_metadata.GetGlobalRegisters(count);
+	return vector<uint32_t>(list, list + count);
 }
 
 
@@ -925,24 +1648,41 @@ Ref<Architecture> CoreArchitecture::GetAssociatedArchitectureByAddress(uint64_t&
 
 bool CoreArchitecture::GetInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen, InstructionInfo& result)
 {
-	return BNGetInstructionInfo(m_object, data, addr, maxLen, &result);
+	InstructionDecodeCache* cache = m_decodeCache;
+	bool ok;
+	if (cache && cache->LookupInstructionInfo(data, addr, maxLen, result, ok))
+		return ok;
+
+	ok = BNGetInstructionInfo(m_object, data, addr, maxLen, &result);
+	if (cache)
+		cache->StoreInstructionInfo(data, addr, maxLen, result, ok);
+	return ok;
 }
 
 
 bool CoreArchitecture::GetInstructionText(const uint8_t* data, uint64_t addr, size_t& len, std::vector<InstructionTextToken>& result)
 {
+	InstructionDecodeCache* cache = m_decodeCache;
+	bool ok;
+	if (cache && cache->LookupInstructionText(data, addr, len, result, ok))
+		return ok;
+
+	size_t maxLen = len;
 	BNInstructionTextToken* tokens = nullptr;
 	size_t count = 0;
 	if (!BNGetInstructionText(m_object, data, addr, &len, &tokens, &count))
-		return false;
-
-	for (size_t i = 0; i < count; i++)
 	{
-		result.push_back(InstructionTextToken(tokens[i].type, tokens[i].context, tokens[i].text, tokens[i].address,
-			tokens[i].value, tokens[i].size, tokens[i].operand, tokens[i].confidence));
+		if (cache)
+			cache->StoreInstructionText(data, addr, maxLen, len, vector<InstructionTextToken>(), false);
+		return false;
 	}
 
+	vector<InstructionTextToken> converted = InstructionTextToken::ConvertInstructionTextTokenList(tokens, count);
 	BNFreeInstructionText(tokens, count);
+	if (cache)
+		cache->StoreInstructionText(data, addr, maxLen, len, converted, true);
+
+	result.insert(result.end(), make_move_iterator(converted.begin()), make_move_iterator(converted.end()));
 	return true;
 }
 
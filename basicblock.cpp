@@ -18,6 +18,8 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <algorithm>
+#include <unordered_set>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
@@ -273,19 +275,7 @@ vector<DisassemblyTextLine> BasicBlock::GetDisassemblyText(DisassemblySettings*
 	{
 		DisassemblyTextLine line;
 		line.addr = lines[i].addr;
-		for (size_t j = 0; j < lines[i].count; j++)
-		{
-			InstructionTextToken token;
-			token.type = lines[i].tokens[j].type;
-			token.text = lines[i].tokens[j].text;
-			token.value = lines[i].tokens[j].value;
-			token.size = lines[i].tokens[j].size;
-			token.operand = lines[i].tokens[j].operand;
-			token.context = lines[i].tokens[j].context;
-			token.confidence = lines[i].tokens[j].confidence;
-			token.address = lines[i].tokens[j].address;
-			line.tokens.push_back(token);
-		}
+		line.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].tokens, lines[i].count);
 		result.push_back(line);
 	}
 
@@ -413,3 +403,739 @@ bool BasicBlock::IsBackEdge(BasicBlock* source, BasicBlock* target)
 	}
 	return false;
 }
+
+
+const uint32_t CFGSnapshot::NoBlock;
+
+
+CFGSnapshot::CFGSnapshot(Function* func)
+{
+	size_t count;
+	BNBasicBlock** blocks = BNGetFunctionBasicBlockList(func->GetObject(), &count);
+
+	size_t blockCount = 0;
+	vector<uint32_t> indices(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		indices[i] = (uint32_t)BNGetBasicBlockIndex(blocks[i]);
+		blockCount = max(blockCount, (size_t)indices[i] + 1);
+	}
+
+	m_blocks.resize(blockCount);
+	m_starts.resize(blockCount, 0);
+	m_ends.resize(blockCount, 0);
+	unordered_map<BNBasicBlock*, uint32_t> blockIndices;
+	for (size_t i = 0; i < count; i++)
+	{
+		m_blocks[indices[i]] = new BasicBlock(BNNewBasicBlockReference(blocks[i]));
+		m_starts[indices[i]] = BNGetBasicBlockStart(blocks[i]);
+		m_ends[indices[i]] = BNGetBasicBlockEnd(blocks[i]);
+		blockIndices[blocks[i]] = indices[i];
+	}
+
+	m_outgoingOffsets.reserve(blockCount + 1);
+	for (uint32_t block = 0; block < blockCount; block++)
+	{
+		m_outgoingOffsets.push_back((uint32_t)m_targets.size());
+		if (!m_blocks[block])
+			continue;
+
+		size_t edgeCount;
+		BNBasicBlockEdge* outgoing = BNGetBasicBlockOutgoingEdges(m_blocks[block]->GetObject(), &edgeCount);
+		for (size_t e = 0; e < edgeCount; e++)
+		{
+			uint32_t target = NoBlock;
+			if (outgoing[e].target)
+			{
+				auto j = blockIndices.find(outgoing[e].target);
+				if (j != blockIndices.end())
+					target = j->second;
+			}
+			m_sources.push_back(block);
+			m_targets.push_back(target);
+			m_types.push_back((uint8_t)outgoing[e].type);
+			m_backEdges.push_back(outgoing[e].backEdge ? 1 : 0);
+		}
+		BNFreeBasicBlockEdgeList(outgoing, edgeCount);
+	}
+	m_outgoingOffsets.push_back((uint32_t)m_targets.size());
+	BNFreeBasicBlockList(blocks, count);
+
+	// Incoming edges, grouped by target block
+	m_incomingOffsets.assign(blockCount + 1, 0);
+	for (auto target : m_targets)
+	{
+		if (target != NoBlock)
+			m_incomingOffsets[target + 1]++;
+	}
+	for (size_t i = 0; i < blockCount; i++)
+		m_incomingOffsets[i + 1] += m_incomingOffsets[i];
+	m_incomingEdges.resize(m_incomingOffsets[blockCount]);
+	m_predecessors.resize(m_incomingOffsets[blockCount]);
+	vector<uint32_t> next(m_incomingOffsets.begin(), m_incomingOffsets.end() - 1);
+	for (uint32_t edge = 0; edge < (uint32_t)m_targets.size(); edge++)
+	{
+		if (m_targets[edge] == NoBlock)
+			continue;
+		uint32_t position = next[m_targets[edge]]++;
+		m_incomingEdges[position] = edge;
+		m_predecessors[position] = m_sources[edge];
+	}
+}
+
+
+const uint32_t DominatorTree::NoBlock;
+
+
+static void BuildAdjacency(size_t count, const vector<pair<uint32_t, uint32_t>>& edges, bool reverse,
+	vector<uint32_t>& offsets, vector<uint32_t>& targets)
+{
+	offsets.assign(count + 1, 0);
+	for (auto& i : edges)
+		offsets[(reverse ? i.second : i.first) + 1]++;
+	for (size_t i = 0; i < count; i++)
+		offsets[i + 1] += offsets[i];
+	targets.resize(edges.size());
+	vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+	for (auto& i : edges)
+	{
+		if (reverse)
+			targets[next[i.second]++] = i.first;
+		else
+			targets[next[i.first]++] = i.second;
+	}
+}
+
+
+DominatorTree::DominatorTree(Function* func)
+{
+	Build(CFGSnapshot(func));
+}
+
+
+DominatorTree::DominatorTree(const CFGSnapshot& cfg)
+{
+	Build(cfg);
+}
+
+
+void DominatorTree::Build(const CFGSnapshot& cfg)
+{
+	size_t blockCount = cfg.GetBlockCount();
+	m_blocks.reserve(blockCount);
+	for (size_t i = 0; i < blockCount; i++)
+		m_blocks.push_back(cfg.GetBlock(i));
+
+	m_immediateDominators.assign(blockCount, NoBlock);
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		if (!m_blocks[i])
+			continue;
+		BNBasicBlock* dominator = BNGetBasicBlockImmediateDominator(m_blocks[i]->GetObject());
+		if (!dominator)
+			continue;
+		size_t index = BNGetBasicBlockIndex(dominator);
+		if ((index < blockCount) && m_blocks[index] && (m_blocks[index]->GetObject() == dominator))
+			m_immediateDominators[i] = (uint32_t)index;
+		BNFreeBasicBlock(dominator);
+	}
+
+	vector<pair<uint32_t, uint32_t>> edges;
+	const uint32_t* sources = cfg.GetEdgeSources();
+	const uint32_t* targets = cfg.GetEdgeTargets();
+	for (size_t i = 0; i < cfg.GetEdgeCount(); i++)
+	{
+		if (targets[i] != CFGSnapshot::NoBlock)
+			edges.push_back(make_pair(sources[i], targets[i]));
+	}
+
+	BuildAdjacency(blockCount, edges, false, m_successorOffsets, m_successors);
+	BuildAdjacency(blockCount, edges, true, m_predecessorOffsets, m_predecessors);
+
+	// Dominator tree children, grouped by immediate dominator
+	vector<pair<uint32_t, uint32_t>> treeEdges;
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		if (m_immediateDominators[i] != NoBlock)
+			treeEdges.push_back(make_pair(m_immediateDominators[i], (uint32_t)i));
+	}
+	BuildAdjacency(blockCount, treeEdges, false, m_childOffsets, m_children);
+
+	// Pre and post order numbering of each tree, so that dominance is interval containment
+	m_preorder.assign(blockCount, 0);
+	m_postorder.assign(blockCount, 0);
+	uint32_t preorder = 0;
+	uint32_t postorder = 0;
+	vector<pair<uint32_t, uint32_t>> stack;
+	for (uint32_t root = 0; root < blockCount; root++)
+	{
+		if (m_immediateDominators[root] != NoBlock)
+			continue;
+
+		m_preorder[root] = preorder++;
+		stack.push_back(make_pair(root, m_childOffsets[root]));
+		while (!stack.empty())
+		{
+			uint32_t block = stack.back().first;
+			uint32_t child = stack.back().second;
+			if (child < m_childOffsets[block + 1])
+			{
+				stack.back().second++;
+				uint32_t childBlock = m_children[child];
+				m_preorder[childBlock] = preorder++;
+				stack.push_back(make_pair(childBlock, m_childOffsets[childBlock]));
+				continue;
+			}
+			m_postorder[block] = postorder++;
+			stack.pop_back();
+		}
+	}
+
+	// Dominance frontiers: walk up from each predecessor of a block until reaching its immediate dominator
+	m_bitsetWords = (blockCount + 63) / 64;
+	m_frontiers.assign(blockCount * m_bitsetWords, 0);
+	for (auto& i : edges)
+	{
+		uint32_t block = i.second;
+		uint32_t dominator = m_immediateDominators[block];
+		for (uint32_t runner = i.first; (runner != NoBlock) && (runner != dominator);
+			runner = m_immediateDominators[runner])
+			m_frontiers[(runner * m_bitsetWords) + (block / 64)] |= (uint64_t)1 << (block % 64);
+	}
+}
+
+
+vector<uint64_t> DominatorTree::GetIteratedDominanceFrontier(const vector<size_t>& blocks) const
+{
+	vector<uint64_t> result(m_bitsetWords, 0);
+	vector<uint64_t> queued(m_bitsetWords, 0);
+	vector<size_t> worklist;
+	for (auto i : blocks)
+	{
+		if (queued[i / 64] & ((uint64_t)1 << (i % 64)))
+			continue;
+		queued[i / 64] |= (uint64_t)1 << (i % 64);
+		worklist.push_back(i);
+	}
+
+	while (!worklist.empty())
+	{
+		const uint64_t* frontier = GetDominanceFrontier(worklist.back());
+		worklist.pop_back();
+		for (size_t word = 0; word < m_bitsetWords; word++)
+		{
+			uint64_t added = frontier[word] & ~result[word];
+			if (!added)
+				continue;
+			result[word] |= added;
+
+			// Blocks entering the frontier contribute their own frontiers in turn
+			uint64_t pending = added & ~queued[word];
+			queued[word] |= pending;
+			for (size_t bit = 0; pending; bit++, pending >>= 1)
+			{
+				if (pending & 1)
+					worklist.push_back((word * 64) + bit);
+			}
+		}
+	}
+	return result;
+}
+
+
+const uint32_t LoopInfo::NoLoop;
+
+
+LoopInfo::LoopInfo(Function* func)
+{
+	DominatorTree dominators(func);
+	Build(dominators);
+}
+
+
+LoopInfo::LoopInfo(const DominatorTree& dominators)
+{
+	Build(dominators);
+}
+
+
+void LoopInfo::Build(const DominatorTree& dominators)
+{
+	size_t blockCount = dominators.GetBlockCount();
+	m_blocks.reserve(blockCount);
+	for (size_t i = 0; i < blockCount; i++)
+		m_blocks.push_back(dominators.GetBlock(i));
+	m_bitsetWords = (blockCount + 63) / 64;
+	m_innermostLoops.assign(blockCount, NoLoop);
+
+	// A block is a loop header if it dominates one of its predecessors. Visiting headers in dominator tree
+	// preorder finds every loop before the loops nested inside it.
+	vector<uint32_t> headers;
+	for (uint32_t block = 0; block < blockCount; block++)
+	{
+		size_t count;
+		const uint32_t* preds = dominators.GetPredecessors(block, count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (dominators.Dominates(block, preds[i]))
+			{
+				headers.push_back(block);
+				break;
+			}
+		}
+	}
+	sort(headers.begin(), headers.end(), [&](uint32_t a, uint32_t b) {
+		return dominators.GetPreorderIndex(a) < dominators.GetPreorderIndex(b);
+	});
+
+	vector<uint32_t> worklist;
+	for (auto header : headers)
+	{
+		uint32_t loopIndex = (uint32_t)m_loops.size();
+		m_bodies.resize(m_bodies.size() + m_bitsetWords, 0);
+		uint64_t* body = &m_bodies[loopIndex * m_bitsetWords];
+		body[header / 64] |= (uint64_t)1 << (header % 64);
+
+		Loop loop;
+		loop.header = header;
+		size_t count;
+		const uint32_t* preds = dominators.GetPredecessors(header, count);
+		for (size_t i = 0; i < count; i++)
+		{
+			uint32_t source = preds[i];
+			if (!dominators.Dominates(header, source))
+				continue;
+			loop.backEdgeSources.push_back(source);
+			if (!((body[source / 64] >> (source % 64)) & 1))
+			{
+				body[source / 64] |= (uint64_t)1 << (source % 64);
+				worklist.push_back(source);
+			}
+		}
+		sort(loop.backEdgeSources.begin(), loop.backEdgeSources.end());
+		loop.backEdgeSources.erase(unique(loop.backEdgeSources.begin(), loop.backEdgeSources.end()),
+			loop.backEdgeSources.end());
+
+		// The body is everything that reaches a back edge without passing through the header
+		while (!worklist.empty())
+		{
+			uint32_t block = worklist.back();
+			worklist.pop_back();
+			preds = dominators.GetPredecessors(block, count);
+			for (size_t i = 0; i < count; i++)
+			{
+				uint32_t pred = preds[i];
+				if ((body[pred / 64] >> (pred % 64)) & 1)
+					continue;
+				if (!dominators.Dominates(header, pred))
+					continue;
+				body[pred / 64] |= (uint64_t)1 << (pred % 64);
+				worklist.push_back(pred);
+			}
+		}
+
+		// Outer loops were assigned first, so the innermost loop containing the header so far is the parent
+		loop.parent = m_innermostLoops[header];
+		loop.depth = (loop.parent == NoLoop) ? 1 : (m_loops[loop.parent].depth + 1);
+
+		// Visit only the blocks of the body, so that building every loop stays proportional to the loop sizes
+		for (size_t word = 0; word < m_bitsetWords; word++)
+		{
+			uint64_t bits = body[word];
+			for (uint32_t block = (uint32_t)(word * 64); bits; block++, bits >>= 1)
+			{
+				if (!(bits & 1))
+					continue;
+				m_innermostLoops[block] = loopIndex;
+
+				const uint32_t* succs = dominators.GetSuccessors(block, count);
+				for (size_t i = 0; i < count; i++)
+				{
+					if (!((body[succs[i] / 64] >> (succs[i] % 64)) & 1))
+						loop.exits.push_back(make_pair(block, succs[i]));
+				}
+			}
+		}
+
+		m_loops.push_back(move(loop));
+	}
+}
+
+
+void LoopInfoCache::UpdateTracker::OnAnalysisFunctionRemoved(BinaryView*, Function* func)
+{
+	m_cache->Remove(func);
+}
+
+
+void LoopInfoCache::UpdateTracker::OnAnalysisFunctionUpdated(BinaryView*, Function* func)
+{
+	m_cache->Update(func);
+}
+
+
+LoopInfoCache::LoopInfoCache(BinaryView* view): m_view(view->GetObject()), m_viewRef(view)
+{
+	m_tracker.reset(new UpdateTracker(this));
+	BNRegisterDataNotification(m_view, m_tracker->GetCallbacks());
+}
+
+
+LoopInfoCache::LoopInfoCache(BNBinaryView* view): m_view(view)
+{
+	m_tracker.reset(new UpdateTracker(this));
+	BNRegisterDataNotification(m_view, m_tracker->GetCallbacks());
+}
+
+
+LoopInfoCache::~LoopInfoCache()
+{
+	BNUnregisterDataNotification(m_view, m_tracker->GetCallbacks());
+}
+
+
+struct SharedLoopInfoCaches
+{
+	mutex lock;
+	unordered_map<BNBinaryView*, shared_ptr<LoopInfoCache>> caches;
+	BNObjectDestructionCallbacks callbacks;
+};
+
+
+static SharedLoopInfoCaches& GetSharedLoopInfoCaches()
+{
+	// Leaked, so that views destroyed during process exit can still remove their caches
+	static SharedLoopInfoCaches* shared = new SharedLoopInfoCaches();
+	return *shared;
+}
+
+
+void LoopInfoCache::DestructBinaryViewCallback(void*, BNBinaryView* view)
+{
+	SharedLoopInfoCaches& shared = GetSharedLoopInfoCaches();
+	shared_ptr<LoopInfoCache> cache;
+	{
+		unique_lock<mutex> lock(shared.lock);
+		auto i = shared.caches.find(view);
+		if (i == shared.caches.end())
+			return;
+		cache = i->second;
+		shared.caches.erase(i);
+	}
+
+	// Destroy the cache outside the lock, as releasing its functions can call back into the core
+	cache.reset();
+}
+
+
+shared_ptr<LoopInfoCache> LoopInfoCache::GetForView(BinaryView* view)
+{
+	SharedLoopInfoCaches& shared = GetSharedLoopInfoCaches();
+	unique_lock<mutex> lock(shared.lock);
+	if (!shared.callbacks.destructBinaryView)
+	{
+		shared.callbacks.context = nullptr;
+		shared.callbacks.destructBinaryView = DestructBinaryViewCallback;
+		shared.callbacks.destructFileMetadata = nullptr;
+		shared.callbacks.destructFunction = nullptr;
+		BNRegisterObjectDestructionCallbacks(&shared.callbacks);
+	}
+
+	// The shared cache does not hold a reference to the view, so the view is still destroyed when closed
+	shared_ptr<LoopInfoCache>& cache = shared.caches[view->GetObject()];
+	if (!cache)
+		cache.reset(new LoopInfoCache(view->GetObject()));
+	return cache;
+}
+
+
+void LoopInfoCache::Update(Function* func)
+{
+	unique_lock<mutex> lock(m_mutex);
+	auto i = m_entries.find(func->GetObject());
+	if (i == m_entries.end())
+		return;
+	i->second.loops.reset();
+	i->second.version++;
+}
+
+
+void LoopInfoCache::Remove(Function* func)
+{
+	unique_lock<mutex> lock(m_mutex);
+	m_entries.erase(func->GetObject());
+}
+
+
+shared_ptr<const LoopInfo> LoopInfoCache::GetLoopInfo(Function* func)
+{
+	uint64_t version;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		auto i = m_entries.find(func->GetObject());
+		if (i == m_entries.end())
+		{
+			// Create the entry before computing, so that an update arriving meanwhile marks the result stale
+			Entry entry;
+			entry.func = func;
+			entry.version = 0;
+			i = m_entries.insert(make_pair(func->GetObject(), entry)).first;
+		}
+		else if (i->second.loops)
+		{
+			return i->second.loops;
+		}
+		version = i->second.version;
+	}
+
+	// Compute without holding the lock, so that other functions can be queried in parallel
+	shared_ptr<const LoopInfo> loops = make_shared<LoopInfo>(func);
+
+	unique_lock<mutex> lock(m_mutex);
+	auto i = m_entries.find(func->GetObject());
+	if ((i != m_entries.end()) && (i->second.version == version) && (!i->second.loops))
+		i->second.loops = loops;
+	return loops;
+}
+
+
+void LoopInfoCache::Invalidate()
+{
+	unique_lock<mutex> lock(m_mutex);
+	for (auto& i : m_entries)
+	{
+		i.second.loops.reset();
+		i.second.version++;
+	}
+}
+
+
+static bool CompareIndexRanges(const BasicBlockIndex::Range& a, const BasicBlockIndex::Range& b)
+{
+	if (a.start != b.start)
+		return a.start < b.start;
+	return a.end < b.end;
+}
+
+
+BasicBlockIndex::BasicBlockIndex(BinaryView* view)
+{
+	m_functions = view->GetAnalysisFunctionList();
+	for (size_t i = 0; i < m_functions.size(); i++)
+		AddFunctionBlocks(i, m_ranges);
+	sort(m_ranges.begin(), m_ranges.end(), CompareIndexRanges);
+	ComputeMaxEnd();
+}
+
+
+BasicBlockIndex::BasicBlockIndex(const BasicBlockIndex& base, const vector<Ref<Function>>& updated,
+	const vector<BNFunction*>& removed)
+{
+	unordered_set<BNFunction*> replaced(removed.begin(), removed.end());
+	for (auto& i : updated)
+		replaced.insert(i->GetObject());
+
+	// Carry over the unchanged functions and their ranges, which are already in order
+	static const size_t dropped = (size_t)-1;
+	vector<size_t> functionMap(base.m_functions.size(), dropped);
+	for (size_t i = 0; i < base.m_functions.size(); i++)
+	{
+		if (replaced.count(base.m_functions[i]->GetObject()))
+			continue;
+		functionMap[i] = m_functions.size();
+		m_functions.push_back(base.m_functions[i]);
+	}
+
+	m_ranges.reserve(base.m_ranges.size());
+	m_blocks.reserve(base.m_blocks.size());
+	for (auto& i : base.m_ranges)
+	{
+		if (functionMap[i.function] == dropped)
+			continue;
+		Range range = i;
+		range.function = functionMap[i.function];
+		range.block = m_blocks.size();
+		m_ranges.push_back(range);
+		m_blocks.push_back(base.m_blocks[i.block]);
+	}
+
+	// Merge in the current blocks of the updated functions
+	vector<Range> added;
+	for (auto& i : updated)
+	{
+		m_functions.push_back(i);
+		AddFunctionBlocks(m_functions.size() - 1, added);
+	}
+	sort(added.begin(), added.end(), CompareIndexRanges);
+	size_t kept = m_ranges.size();
+	m_ranges.insert(m_ranges.end(), added.begin(), added.end());
+	inplace_merge(m_ranges.begin(), m_ranges.begin() + kept, m_ranges.end(), CompareIndexRanges);
+	ComputeMaxEnd();
+}
+
+
+void BasicBlockIndex::AddFunctionBlocks(size_t function, vector<Range>& ranges)
+{
+	for (auto& block : m_functions[function]->GetBasicBlocks())
+	{
+		Range range;
+		range.start = block->GetStart();
+		range.end = block->GetEnd();
+		range.function = function;
+		range.block = m_blocks.size();
+		ranges.push_back(range);
+		m_blocks.push_back(block);
+	}
+}
+
+
+void BasicBlockIndex::ComputeMaxEnd()
+{
+	m_maxEnd.clear();
+	m_maxEnd.reserve(m_ranges.size());
+	uint64_t maxEnd = 0;
+	for (auto& i : m_ranges)
+	{
+		if (i.end > maxEnd)
+			maxEnd = i.end;
+		m_maxEnd.push_back(maxEnd);
+	}
+}
+
+
+void BasicBlockIndex::GetCandidates(uint64_t start, uint64_t end, size_t& first, size_t& last) const
+{
+	// Ranges starting at or after end cannot overlap, and neither can any range before the first one whose
+	// running maximum end passes start
+	last = lower_bound(m_ranges.begin(), m_ranges.end(), end,
+		[](const Range& range, uint64_t value) { return range.start < value; }) - m_ranges.begin();
+	first = upper_bound(m_maxEnd.begin(), m_maxEnd.begin() + last, start) - m_maxEnd.begin();
+}
+
+
+vector<Ref<Function>> BasicBlockIndex::GetFunctionsInRange(uint64_t start, uint64_t end) const
+{
+	vector<Ref<Function>> result;
+	vector<bool> found(m_functions.size(), false);
+	ForEachOverlapping(start, end, [&](const Range& range) {
+		if (found[range.function])
+			return;
+		found[range.function] = true;
+		result.push_back(m_functions[range.function]);
+	});
+	return result;
+}
+
+
+const BasicBlockIndex::Range* BasicBlockIndex::GetRangeForAddress(uint64_t addr) const
+{
+	size_t first, last;
+	GetCandidates(addr, addr + 1, first, last);
+	for (size_t i = last; i > first; i--)
+	{
+		if (m_ranges[i - 1].end > addr)
+			return &m_ranges[i - 1];
+	}
+	return nullptr;
+}
+
+
+vector<Ref<Function>> BasicBlockIndex::GetFunctionsForAddress(uint64_t addr) const
+{
+	return GetFunctionsInRange(addr, addr + 1);
+}
+
+
+vector<Ref<BasicBlock>> BasicBlockIndex::GetBasicBlocksForAddress(uint64_t addr) const
+{
+	vector<Ref<BasicBlock>> result;
+	ForEachContaining(addr, [&](const Range& range) { result.push_back(m_blocks[range.block]); });
+	return result;
+}
+
+
+void BasicBlockIndexCache::UpdateTracker::OnAnalysisFunctionAdded(BinaryView*, Function* func)
+{
+	m_cache->QueueUpdate(func);
+}
+
+
+void BasicBlockIndexCache::UpdateTracker::OnAnalysisFunctionRemoved(BinaryView*, Function* func)
+{
+	m_cache->QueueRemoval(func);
+}
+
+
+void BasicBlockIndexCache::UpdateTracker::OnAnalysisFunctionUpdated(BinaryView*, Function* func)
+{
+	m_cache->QueueUpdate(func);
+}
+
+
+BasicBlockIndexCache::BasicBlockIndexCache(BinaryView* view): m_view(view), m_populated(false)
+{
+	m_tracker.reset(new UpdateTracker(this));
+	m_view->RegisterNotification(m_tracker.get());
+}
+
+
+BasicBlockIndexCache::~BasicBlockIndexCache()
+{
+	m_view->UnregisterNotification(m_tracker.get());
+}
+
+
+void BasicBlockIndexCache::QueueUpdate(Function* func)
+{
+	unique_lock<mutex> lock(m_pendingMutex);
+	m_pendingRemovals.erase(func->GetObject());
+	m_pendingUpdates[func->GetObject()] = func;
+}
+
+
+void BasicBlockIndexCache::QueueRemoval(Function* func)
+{
+	unique_lock<mutex> lock(m_pendingMutex);
+	m_pendingUpdates.erase(func->GetObject());
+	m_pendingRemovals[func->GetObject()] = func;
+}
+
+
+shared_ptr<const BasicBlockIndex> BasicBlockIndexCache::GetIndex()
+{
+	unique_lock<mutex> lock(m_mutex);
+
+	unordered_map<BNFunction*, Ref<Function>> updates, removals;
+	{
+		unique_lock<mutex> pendingLock(m_pendingMutex);
+		updates.swap(m_pendingUpdates);
+		removals.swap(m_pendingRemovals);
+	}
+
+	if ((!m_populated.exchange(true)) || (!m_index))
+	{
+		// A full build already reflects every change queued before it started
+		m_index = make_shared<BasicBlockIndex>(m_view);
+		return m_index;
+	}
+
+	if (updates.empty() && removals.empty())
+		return m_index;
+
+	vector<Ref<Function>> updated;
+	updated.reserve(updates.size());
+	for (auto& i : updates)
+		updated.push_back(i.second);
+	vector<BNFunction*> removed;
+	removed.reserve(removals.size());
+	for (auto& i : removals)
+		removed.push_back(i.first);
+	m_index = make_shared<BasicBlockIndex>(*m_index, updated, removed);
+	return m_index;
+}
+
+
+void BasicBlockIndexCache::Invalidate()
+{
+	m_populated = false;
+}
@@ -28,12 +28,15 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
 #include <unordered_map>
 #include <exception>
 #include <functional>
 #include <set>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <thread>
 #include "binaryninjacore.h"
 #include "json/json.h"
 
@@ -202,12 +205,37 @@ namespace BinaryNinja
 				m_obj->AddRef();
 		}
 
+		Ref<T>(Ref<T>&& obj) NOEXCEPT: m_obj(obj.m_obj)
+		{
+			obj.m_obj = NULL;
+		}
+
 		~Ref<T>()
 		{
 			if (m_obj)
 				m_obj->Release();
 		}
 
+		/*! Adopt wraps an object that was just created and has not been shared with anyone yet. The first
+		    reference is taken without an atomic operation, and for core objects the reference passed to the
+		    object's constructor is kept as-is. Objects that are already referenced fall back to a normal AddRef.
+
+		    \param obj newly created object, typically the result of a new expression
+		*/
+		static Ref<T> Adopt(T* obj)
+		{
+			Ref<T> result;
+			if (obj)
+			{
+				if (obj->m_refs == 0)
+					obj->m_refs = 1;
+				else
+					obj->AddRef();
+			}
+			result.m_obj = obj;
+			return result;
+		}
+
 		Ref<T>& operator=(const Ref<T>& obj)
 		{
 			T* oldObj = m_obj;
@@ -219,6 +247,19 @@ namespace BinaryNinja
 			return *this;
 		}
 
+		Ref<T>& operator=(Ref<T>&& obj) NOEXCEPT
+		{
+			if (this != &obj)
+			{
+				T* oldObj = m_obj;
+				m_obj = obj.m_obj;
+				obj.m_obj = NULL;
+				if (oldObj)
+					oldObj->Release();
+			}
+			return *this;
+		}
+
 		Ref<T>& operator=(T* obj)
 		{
 			T* oldObj = m_obj;
@@ -333,10 +374,22 @@ namespace BinaryNinja
 		{
 		}
 
+		Confidence(T&& value): ConfidenceBase(BN_FULL_CONFIDENCE), m_value(std::move(value))
+		{
+		}
+
+		Confidence(T&& value, uint8_t conf): ConfidenceBase(conf), m_value(std::move(value))
+		{
+		}
+
 		Confidence(const Confidence<T>& v): ConfidenceBase(v.m_confidence), m_value(v.m_value)
 		{
 		}
 
+		Confidence(Confidence<T>&& v) NOEXCEPT: ConfidenceBase(v.m_confidence), m_value(std::move(v.m_value))
+		{
+		}
+
 		operator T() const { return m_value; }
 		T* operator->() { return &m_value; }
 		const T* operator->() const { return &m_value; }
@@ -356,6 +409,13 @@ namespace BinaryNinja
 			return *this;
 		}
 
+		Confidence<T>& operator=(Confidence<T>&& v) NOEXCEPT
+		{
+			m_value = std::move(v.m_value);
+			m_confidence = v.m_confidence;
+			return *this;
+		}
+
 		Confidence<T>& operator=(const T& value)
 		{
 			m_value = value;
@@ -411,10 +471,22 @@ namespace BinaryNinja
 		{
 		}
 
+		Confidence(Ref<T>&& value): ConfidenceBase(value ? BN_FULL_CONFIDENCE : 0), m_value(std::move(value))
+		{
+		}
+
+		Confidence(Ref<T>&& value, uint8_t conf): ConfidenceBase(conf), m_value(std::move(value))
+		{
+		}
+
 		Confidence(const Confidence<Ref<T>>& v): ConfidenceBase(v.m_confidence), m_value(v.m_value)
 		{
 		}
 
+		Confidence(Confidence<Ref<T>>&& v) NOEXCEPT: ConfidenceBase(v.m_confidence), m_value(std::move(v.m_value))
+		{
+		}
+
 		operator Ref<T>() const { return m_value; }
 		operator T*() const { return m_value.GetPtr(); }
 		T* operator->() const { return m_value.GetPtr(); }
@@ -423,6 +495,7 @@ namespace BinaryNinja
 		const Ref<T>& GetValue() const { return m_value; }
 		void SetValue(T* value) { m_value = value; }
 		void SetValue(const Ref<T>& value) { m_value = value; }
+		void SetValue(Ref<T>&& value) { m_value = std::move(value); }
 
 		Confidence<Ref<T>>& operator=(const Confidence<Ref<T>>& v)
 		{
@@ -431,6 +504,13 @@ namespace BinaryNinja
 			return *this;
 		}
 
+		Confidence<Ref<T>>& operator=(Confidence<Ref<T>>&& v) NOEXCEPT
+		{
+			m_value = std::move(v.m_value);
+			m_confidence = v.m_confidence;
+			return *this;
+		}
+
 		Confidence<Ref<T>>& operator=(T* value)
 		{
 			m_value = value;
@@ -445,6 +525,13 @@ namespace BinaryNinja
 			return *this;
 		}
 
+		Confidence<Ref<T>>& operator=(Ref<T>&& value)
+		{
+			m_confidence = value ? BN_FULL_CONFIDENCE : 0;
+			m_value = std::move(value);
+			return *this;
+		}
+
 		bool operator<(const Confidence<Ref<T>>& a) const
 		{
 			if (m_value < a.m_value)
@@ -686,6 +773,8 @@ namespace BinaryNinja
 		static QualifiedName FromAPIObject(BNQualifiedName* name);
 	};
 
+	class DataBufferView;
+
 	class DataBuffer
 	{
 		BNDataBuffer* m_buffer;
@@ -695,13 +784,22 @@ namespace BinaryNinja
 		DataBuffer(size_t len);
 		DataBuffer(const void* data, size_t len);
 		DataBuffer(const DataBuffer& buf);
+		/*! A moved from DataBuffer is left empty and can still be used. */
+		DataBuffer(DataBuffer&& buf) NOEXCEPT;
+		DataBuffer(const DataBufferView& view);
 		DataBuffer(BNDataBuffer* buf);
 		~DataBuffer();
 
 		DataBuffer& operator=(const DataBuffer& buf);
+		DataBuffer& operator=(DataBuffer&& buf) NOEXCEPT;
 
 		BNDataBuffer* GetBufferObject() const { return m_buffer; }
 
+		/*! DetachBufferObject gives up ownership of the underlying core buffer without freeing it. The
+		    DataBuffer must not be used afterwards except to be destroyed or assigned to.
+		*/
+		BNDataBuffer* DetachBufferObject();
+
 		void* GetData();
 		const void* GetData() const;
 		void* GetDataAt(size_t offset);
@@ -715,6 +813,8 @@ namespace BinaryNinja
 		void AppendByte(uint8_t val);
 
 		DataBuffer GetSlice(size_t start, size_t len);
+		DataBufferView GetView() const;
+		DataBufferView GetView(size_t start, size_t len) const;
 
 		uint8_t& operator[](size_t offset);
 		const uint8_t& operator[](size_t offset) const;
@@ -728,6 +828,41 @@ namespace BinaryNinja
 		bool ZlibDecompress(DataBuffer& output) const;
 	};
 
+	/*! DataBufferView is a non-owning pointer and length into memory owned by someone else, usually a
+	    DataBuffer. Creating, copying and slicing a view never allocates or copies the underlying bytes. The
+	    view is only valid while the memory it refers to is alive and not resized.
+	*/
+	class DataBufferView
+	{
+		const uint8_t* m_data;
+		size_t m_length;
+
+	public:
+		DataBufferView(): m_data(nullptr), m_length(0) {}
+		DataBufferView(const void* data, size_t len): m_data((const uint8_t*)data), m_length(len) {}
+		DataBufferView(const DataBuffer& buf): m_data((const uint8_t*)buf.GetData()), m_length(buf.GetLength()) {}
+
+		const void* GetData() const { return m_data; }
+		const void* GetDataAt(size_t offset) const { return m_data + offset; }
+		size_t GetLength() const { return m_length; }
+		bool IsEmpty() const { return m_length == 0; }
+
+		const uint8_t* begin() const { return m_data; }
+		const uint8_t* end() const { return m_data + m_length; }
+		const uint8_t& operator[](size_t offset) const { return m_data[offset]; }
+
+		DataBufferView GetSlice(size_t start, size_t len) const
+		{
+			if (start > m_length)
+				start = m_length;
+			if (len > (m_length - start))
+				len = m_length - start;
+			return DataBufferView(m_data + start, len);
+		}
+
+		DataBuffer ToDataBuffer() const { return DataBuffer(m_data, m_length); }
+	};
+
 	class TemporaryFile: public CoreRefCountObject<BNTemporaryFile, BNNewTemporaryFileReference, BNFreeTemporaryFile>
 	{
 	public:
@@ -913,6 +1048,12 @@ namespace BinaryNinja
 		virtual uint64_t GetLength() const = 0;
 		virtual size_t Read(void* dest, uint64_t offset, size_t len) = 0;
 		virtual size_t Write(uint64_t offset, const void* src, size_t len) = 0;
+
+		/*! GetPointer returns a pointer to len bytes of the file starting at offset when the accessor keeps the
+		    file contents in memory, or nullptr when the range is not directly addressable. Accessors that return
+		    a pointer are read without an intermediate copy into a caller buffer.
+		*/
+		virtual const void* GetPointer(uint64_t offset, size_t len) { (void)offset; (void)len; return nullptr; }
 	};
 
 	class CoreFileAccessor: public FileAccessor
@@ -926,8 +1067,38 @@ namespace BinaryNinja
 		virtual size_t Write(uint64_t offset, const void* src, size_t len) override;
 	};
 
+	/*! MappedFileAccessor maps a file into memory instead of reading it through a file handle. Reads are served
+	    from the mapping and GetPointer exposes it directly, so large inputs are only ever held once, in the page
+	    cache. A writable mapping writes through to the file but cannot change its length. An empty file is
+	    valid but has nothing mapped, so GetPointer always returns nullptr for it.
+	*/
+	class MappedFileAccessor: public FileAccessor
+	{
+		uint8_t* m_data;
+		uint64_t m_length;
+		bool m_writable;
+		bool m_valid;
+#ifdef WIN32
+		HANDLE m_file, m_mapping;
+#endif
+
+	public:
+		MappedFileAccessor(const std::string& path, bool writable = false);
+		MappedFileAccessor(const MappedFileAccessor&) = delete;
+		MappedFileAccessor& operator=(const MappedFileAccessor&) = delete;
+		virtual ~MappedFileAccessor();
+
+		virtual bool IsValid() const override { return m_valid; }
+		virtual uint64_t GetLength() const override { return m_length; }
+		virtual size_t Read(void* dest, uint64_t offset, size_t len) override;
+		virtual size_t Write(uint64_t offset, const void* src, size_t len) override;
+		virtual const void* GetPointer(uint64_t offset, size_t len) override;
+	};
+
 	class Function;
 	class BasicBlock;
+	class CFGSnapshot;
+	class LoopInfo;
 
 	class Symbol: public CoreRefCountObject<BNSymbol, BNNewSymbolReference, BNFreeSymbol>
 	{
@@ -973,6 +1144,11 @@ namespace BinaryNinja
 			size_t operand = BN_INVALID_OPERAND, uint8_t confidence = BN_FULL_CONFIDENCE);
 
 		InstructionTextToken WithConfidence(uint8_t conf);
+
+		static std::vector<InstructionTextToken> ConvertInstructionTextTokenList(
+			const BNInstructionTextToken* tokens, size_t count);
+		static BNInstructionTextToken* CreateInstructionTextTokenList(const std::vector<InstructionTextToken>& tokens);
+		static void FreeInstructionTextTokenList(BNInstructionTextToken* tokens);
 	};
 
 	struct DisassemblyTextLine
@@ -1039,6 +1215,9 @@ namespace BinaryNinja
 
 	struct QualifiedNameAndType;
 	class Metadata;
+	class FunctionCursor;
+	class SymbolCursor;
+	class DataVariableCursor;
 
 	class QueryMetadataException: public std::exception
 	{
@@ -1053,6 +1232,17 @@ namespace BinaryNinja
 	*/
 	class BinaryView: public CoreRefCountObject<BNBinaryView, BNNewViewReference, BNFreeBinaryView>
 	{
+		struct DirectReadRegion
+		{
+			const uint8_t* data;
+			uint64_t start, length;
+		};
+
+		// Published as a whole with atomic_load/atomic_store, as analysis threads read it while it is replaced
+		std::shared_ptr<const DirectReadRegion> m_directRead;
+
+		void DropDirectReadRegion(uint64_t offset, uint64_t len);
+
 	protected:
 		Ref<FileMetadata> m_file; //!< The underlying file
 
@@ -1090,6 +1280,14 @@ namespace BinaryNinja
 
 		virtual bool PerformSave(FileAccessor* file);
 
+		/*! SetDirectReadRegion lets reads of [start, start + len) be served by copying straight out of data,
+		    usually a MappedFileAccessor mapping, without going through PerformRead. The memory must stay valid
+		    and unchanged for as long as the region is set, and until reads that started before it was removed
+		    have returned. Pass a null data pointer to remove the region. Writes that overlap the region, and
+		    inserts or removals before its end, remove it so that later reads go through PerformRead.
+		*/
+		void SetDirectReadRegion(uint64_t start, const void* data, uint64_t len);
+
 		void NotifyDataWritten(uint64_t offset, size_t len);
 		void NotifyDataInserted(uint64_t offset, size_t len);
 		void NotifyDataRemoved(uint64_t offset, uint64_t len);
@@ -1148,6 +1346,16 @@ namespace BinaryNinja
 		size_t Read(void* dest, uint64_t offset, size_t len);
 		DataBuffer ReadBuffer(uint64_t offset, size_t len);
 
+		/*! ReadBuffer reads into caller owned storage, reusing its allocation across calls, and returns a view
+		    of the bytes that were actually read. Scanning a large view in chunks through the same storage keeps
+		    memory use bounded by the chunk size.
+
+		    \param offset virtual address to read from
+		    \param len maximum number of bytes to read
+		    \param storage buffer that receives the data, grown only when it is too small
+		*/
+		DataBufferView ReadBuffer(uint64_t offset, size_t len, DataBuffer& storage);
+
 		size_t Write(uint64_t offset, const void* data, size_t len);
 		size_t WriteBuffer(uint64_t offset, const DataBuffer& data);
 
@@ -1205,9 +1413,26 @@ namespace BinaryNinja
 		void UndefineUserDataVariable(uint64_t addr);
 
 		std::map<uint64_t, DataVariable> GetDataVariables();
+		DataVariableCursor GetDataVariableCursor(size_t batchSize = 1024);
 		bool GetDataVariableAtAddress(uint64_t addr, DataVariable& var);
 
 		std::vector<Ref<Function>> GetAnalysisFunctionList();
+		FunctionCursor GetAnalysisFunctionCursor(size_t batchSize = 1024);
+
+		/*! ParallelForEachFunction calls callback once for every analysis function, spread over a pool of worker
+		    threads. The function list is split into chunks and idle workers steal chunks from busy ones, so
+		    uneven per-function cost still keeps every worker busy. The call returns once every function has
+		    been visited. If a callback throws, the remaining work is abandoned and the first exception is
+		    rethrown on the calling thread.
+
+		    \param callback called with each function, concurrently from several threads
+		    \param threads number of workers, or 0 to use the core's worker thread count
+		    \param advancedAnalysis hold an AdvancedFunctionAnalysisDataRequestor for each function while its
+		           callback runs, scoped to the worker that is processing it
+		*/
+		void ParallelForEachFunction(const std::function<void(Function* func)>& callback, size_t threads = 0,
+			bool advancedAnalysis = false);
+
 		bool HasFunctions() const;
 		Ref<Function> GetAnalysisFunction(Platform* platform, uint64_t addr);
 		Ref<Function> GetRecentAnalysisFunctionForAddress(uint64_t addr);
@@ -1228,6 +1453,8 @@ namespace BinaryNinja
 		std::vector<Ref<Symbol>> GetSymbols(uint64_t start, uint64_t len);
 		std::vector<Ref<Symbol>> GetSymbolsOfType(BNSymbolType type);
 		std::vector<Ref<Symbol>> GetSymbolsOfType(BNSymbolType type, uint64_t start, uint64_t len);
+		SymbolCursor GetSymbolCursor(size_t batchSize = 4096);
+		SymbolCursor GetSymbolCursorOfType(BNSymbolType type, size_t batchSize = 4096);
 
 		void DefineAutoSymbol(Ref<Symbol> sym);
 		void DefineAutoSymbolAndVariableOrFunction(Ref<Platform> platform, Ref<Symbol> sym, Ref<Type> type);
@@ -1343,6 +1570,86 @@ namespace BinaryNinja
 		BinaryData(FileMetadata* file, FileAccessor* accessor);
 	};
 
+	/*! BatchCursor walks a sequence that is fetched from the core a batch at a time. Only the current batch is
+	    held in memory, and it is released as soon as the cursor moves past it. Call Next until it returns false.
+	*/
+	template <class T>
+	class BatchCursor
+	{
+		std::vector<T> m_batch;
+		size_t m_index;
+		bool m_done;
+
+	protected:
+		size_t m_batchSize;
+
+		//! Appends the next batch of items to batch, returning false once the sequence is exhausted
+		virtual bool FetchBatch(std::vector<T>& batch) = 0;
+
+	public:
+		BatchCursor(size_t batchSize): m_index(0), m_done(false), m_batchSize(batchSize ? batchSize : 1) {}
+		virtual ~BatchCursor() {}
+
+		bool Next(T& result)
+		{
+			while (m_index >= m_batch.size())
+			{
+				if (m_done)
+					return false;
+				m_batch.clear();
+				m_index = 0;
+				if (!FetchBatch(m_batch))
+					m_done = true;
+			}
+			result = std::move(m_batch[m_index++]);
+			return true;
+		}
+	};
+
+	//! Walks the analysis functions of a view in address order
+	class FunctionCursor: public BatchCursor<Ref<Function>>
+	{
+		Ref<BinaryView> m_view;
+		uint64_t m_next, m_end;
+		bool m_started;
+
+	protected:
+		virtual bool FetchBatch(std::vector<Ref<Function>>& batch) override;
+
+	public:
+		FunctionCursor(BinaryView* view, size_t batchSize = 1024);
+	};
+
+	//! Walks the symbols of a view in address order, fetching them through address range queries
+	class SymbolCursor: public BatchCursor<Ref<Symbol>>
+	{
+		Ref<BinaryView> m_view;
+		bool m_filterType;
+		BNSymbolType m_type;
+		uint64_t m_next, m_end, m_window;
+
+	protected:
+		virtual bool FetchBatch(std::vector<Ref<Symbol>>& batch) override;
+
+	public:
+		SymbolCursor(BinaryView* view, size_t batchSize = 4096);
+		SymbolCursor(BinaryView* view, BNSymbolType type, size_t batchSize = 4096);
+	};
+
+	//! Walks the data variables of a view in address order
+	class DataVariableCursor: public BatchCursor<DataVariable>
+	{
+		Ref<BinaryView> m_view;
+		uint64_t m_next, m_end;
+		bool m_started;
+
+	protected:
+		virtual bool FetchBatch(std::vector<DataVariable>& batch) override;
+
+	public:
+		DataVariableCursor(BinaryView* view, size_t batchSize = 1024);
+	};
+
 	class Platform;
 
 	class BinaryViewType: public StaticCoreRefCountObject<BNBinaryViewType>
@@ -1398,9 +1705,32 @@ namespace BinaryNinja
 
 	class BinaryReader
 	{
+		class WindowInvalidator: public BinaryDataNotification
+		{
+			BinaryReader* m_reader;
+
+		public:
+			WindowInvalidator(BinaryReader* reader): m_reader(reader) {}
+			virtual void OnBinaryDataWritten(BinaryView* view, uint64_t offset, size_t len) override;
+			virtual void OnBinaryDataInserted(BinaryView* view, uint64_t offset, size_t len) override;
+			virtual void OnBinaryDataRemoved(BinaryView* view, uint64_t offset, uint64_t len) override;
+		};
+
 		Ref<BinaryView> m_view;
 		BNBinaryReader* m_stream;
 
+		BNEndianness m_endian;
+		bool m_buffered;
+		uint64_t m_offset;
+		std::vector<uint8_t> m_window;
+		uint64_t m_windowStart;
+		size_t m_windowLength;
+		std::atomic<bool> m_windowStale;
+		std::unique_ptr<WindowInvalidator> m_invalidator;
+
+		const uint8_t* ReadFromWindow(size_t len);
+		void InvalidateWindow();
+
 	public:
 		BinaryReader(BinaryView* data, BNEndianness endian = LittleEndian);
 		~BinaryReader();
@@ -1408,8 +1738,20 @@ namespace BinaryNinja
 		BNEndianness GetEndianness() const;
 		void SetEndianness(BNEndianness endian);
 
+		/*! EnableBuffering switches the reader to a local read-ahead window. Data is fetched windowSize bytes at a
+		    time through BinaryView::Read and integers are decoded locally, instead of calling into the core for
+		    every field. The window is dropped when the reader seeks outside of it and whenever the view's
+		    contents are written, inserted or removed.
+
+		    \param windowSize number of bytes fetched per refill
+		*/
+		void EnableBuffering(size_t windowSize = 0x10000);
+		void DisableBuffering();
+		bool IsBuffered() const { return m_buffered; }
+
 		void Read(void* dest, size_t len);
 		DataBuffer Read(size_t len);
+		DataBufferView Read(size_t len, DataBuffer& storage);
 		template <typename T> T Read();
 		template <typename T> std::vector<T> ReadVector(size_t count);
 		std::string ReadString(size_t len);
@@ -1459,6 +1801,13 @@ namespace BinaryNinja
 		Ref<BinaryView> m_view;
 		BNBinaryWriter* m_stream;
 
+		BNEndianness m_endian;
+		bool m_transaction;
+		uint64_t m_offset;
+		std::map<uint64_t, std::vector<uint8_t>> m_pending;
+
+		void StageWrite(const void* src, size_t len);
+
 	public:
 		BinaryWriter(BinaryView* data, BNEndianness endian = LittleEndian);
 		~BinaryWriter();
@@ -1466,6 +1815,22 @@ namespace BinaryNinja
 		BNEndianness GetEndianness() const;
 		void SetEndianness(BNEndianness endian);
 
+		/*! BeginTransaction stages all following writes locally instead of sending them to the view. Overlapping
+		    and adjacent writes are merged as they are staged. Writes that are still pending when the writer is
+		    destroyed are discarded.
+		*/
+		void BeginTransaction();
+
+		/*! CommitTransaction writes each contiguous run of staged data to the view with a single
+		    BinaryView::Write, all inside one undo action, and leaves transaction mode.
+
+		    \return false if any run could not be written completely
+		*/
+		bool CommitTransaction();
+		void AbortTransaction();
+		bool IsInTransaction() const { return m_transaction; }
+		size_t GetPendingRunCount() const { return m_pending.size(); }
+
 		void Write(const void* src, size_t len);
 		void Write(const DataBuffer& buf);
 		void Write(const std::string& str);
@@ -1559,21 +1924,412 @@ namespace BinaryNinja
 		void AddBranch(BNBranchType type, uint64_t target = 0, Architecture* arch = nullptr, bool hasDelaySlot = false);
 	};
 
+	/*! InstructionInfoBatch receives the results of Architecture::GetInstructionInfoBatch. Entry i of each
+	    vector describes the i-th decoded instruction. Reusing the same batch across calls keeps its storage.
+	*/
+	struct InstructionInfoBatch
+	{
+		std::vector<uint64_t> addresses;
+		std::vector<InstructionInfo> info;
+
+		size_t GetCount() const { return addresses.size(); }
+		void Clear();
+	};
+
+	/*! InstructionTextBatch receives the results of Architecture::GetInstructionTextBatch. The tokens for all
+	    instructions are stored back to back; instruction i owns tokens [tokenStart[i], tokenStart[i + 1]).
+	    Reusing the same batch across calls keeps its storage.
+	*/
+	struct InstructionTextBatch
+	{
+		std::vector<uint64_t> addresses;
+		std::vector<size_t> lengths;
+		std::vector<size_t> tokenStart;
+		std::vector<InstructionTextToken> tokens;
+
+		size_t GetCount() const { return addresses.size(); }
+		size_t GetTokenCount(size_t i) const { return tokenStart[i + 1] - tokenStart[i]; }
+		const InstructionTextToken* GetTokens(size_t i) const { return tokens.data() + tokenStart[i]; }
+		void Clear();
+	};
+
+	/*!
+		InstructionDecodeCache is a bounded, thread-safe cache of decoded instruction info and text. Entries are
+		keyed by the instruction address and a hash of the instruction bytes, and the bytes are compared on every
+		lookup, so a patched instruction is never served from the cache. Each shard is kept in least recently
+		used order and evicts once it is full.
+	*/
+	class InstructionDecodeCache
+	{
+	public:
+		/*! Invalidator drops the cache entries covering modified data. Register it with each view that is
+		    analyzed with the cached architecture. */
+		class Invalidator: public BinaryDataNotification
+		{
+			InstructionDecodeCache* m_cache;
+
+		public:
+			Invalidator(InstructionDecodeCache* cache): m_cache(cache) {}
+			virtual void OnBinaryDataWritten(BinaryView* view, uint64_t offset, size_t len) override;
+			virtual void OnBinaryDataInserted(BinaryView* view, uint64_t offset, size_t len) override;
+			virtual void OnBinaryDataRemoved(BinaryView* view, uint64_t offset, uint64_t len) override;
+		};
+
+	private:
+		struct Key
+		{
+			uint64_t address;
+			uint64_t hash;
+			size_t length;
+
+			bool operator==(const Key& other) const
+			{
+				return (address == other.address) && (hash == other.hash) && (length == other.length);
+			}
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const
+			{
+				return (size_t)(key.address * 0x9e3779b97f4a7c15ULL ^ key.hash);
+			}
+		};
+
+		struct Entry
+		{
+			Key key;
+			std::vector<uint8_t> bytes;
+			bool hasInfo, infoValid;
+			InstructionInfo info;
+			bool hasText, textValid;
+			size_t textLength;
+			std::vector<InstructionTextToken> text;
+		};
+
+		struct Shard
+		{
+			std::mutex mutex;
+			std::list<Entry> entries;
+			std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+		};
+
+		static constexpr size_t ShardCount = 16;
+
+		Shard m_shards[ShardCount];
+		std::atomic<size_t> m_shardCapacity;
+		size_t m_maxInstructionLength;
+		std::atomic<uint64_t> m_hits, m_misses;
+
+		Key GetKey(const uint8_t* data, uint64_t addr, size_t len) const;
+		Shard& GetShard(const Key& key);
+		Entry* Find(Shard& shard, const Key& key, const uint8_t* data);
+		Entry& Insert(Shard& shard, const Key& key, const uint8_t* data);
+
+	public:
+		InstructionDecodeCache(size_t maxInstructionLength, size_t maxEntries);
+
+		void SetCapacity(size_t maxEntries);
+		size_t GetCapacity() const;
+		size_t GetEntryCount();
+
+		/*! LookupInstructionInfo returns true on a hit, in which case ok receives the cached result of
+		    GetInstructionInfo for the same bytes at addr. */
+		bool LookupInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen, InstructionInfo& result,
+			bool& ok);
+		void StoreInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen, const InstructionInfo& result,
+			bool ok);
+
+		/*! LookupInstructionText returns true on a hit. len is the number of bytes available on entry and receives
+		    the decoded instruction length, as with Architecture::GetInstructionText. */
+		bool LookupInstructionText(const uint8_t* data, uint64_t addr, size_t& len,
+			std::vector<InstructionTextToken>& result, bool& ok);
+		void StoreInstructionText(const uint8_t* data, uint64_t addr, size_t maxLen, size_t len,
+			const std::vector<InstructionTextToken>& result, bool ok);
+
+		void Invalidate();
+		void Invalidate(uint64_t start, uint64_t len);
+
+		uint64_t GetHitCount() const { return m_hits; }
+		uint64_t GetMissCount() const { return m_misses; }
+		void ResetCounters();
+	};
+
+	/*! ArchitectureRegisterEntry describes one register for an ArchitectureMetadataTable. A register is full
+	    width when fullWidthRegister is its own id. */
+	struct ArchitectureRegisterEntry
+	{
+		uint32_t id;
+		const char* name;
+		uint32_t fullWidthRegister;
+		size_t offset;
+		size_t size;
+		BNImplicitRegisterExtend extend;
+		bool global;
+	};
+
+	struct ArchitectureFlagEntry
+	{
+		uint32_t id;
+		const char* name;
+		BNFlagRole role;
+	};
+
+	struct ArchitectureFlagWriteTypeEntry
+	{
+		uint32_t id;
+		const char* name;
+		const uint32_t* flags;
+		size_t flagCount;
+	};
+
+	struct ArchitectureFlagConditionEntry
+	{
+		BNLowLevelILFlagCondition condition;
+		const uint32_t* flags;
+		size_t flagCount;
+	};
+
+	/*!
+		ArchitectureMetadataTable holds an architecture's register and flag metadata in flat arrays, so that the
+		callbacks the core makes can be answered without calling virtual methods or allocating register lists.
+		The entries are plain aggregates and can be declared as static constexpr arrays:
+
+		\code{.cpp}
+		static constexpr ArchitectureRegisterEntry g_registers[] = {
+			{REG_EAX, "eax", REG_EAX, 0, 4, NoExtend, false},
+			{REG_AX, "ax", REG_EAX, 0, 2, NoExtend, false},
+		};
+
+		MyArchitecture::MyArchitecture(): Architecture("myarch")
+		{
+			m_metadata.SetRegisters(g_registers);
+		}
+		\endcode
+
+		Each kind of table is optional. Once one is set, the core is served from it: register and flag lists come
+		straight from the table, and per-register or per-flag queries only fall back to the virtual methods for
+		ids that are not in the table. The default implementations of those virtual methods read the table as
+		well. Tables must be set before the architecture is registered.
+	*/
+	class ArchitectureMetadataTable
+	{
+		struct ListRef
+		{
+			size_t offset, count;
+		};
+
+		std::vector<ArchitectureRegisterEntry> m_registers;
+		std::vector<ArchitectureFlagEntry> m_flags;
+		std::vector<ArchitectureFlagWriteTypeEntry> m_flagWriteTypes;
+		std::vector<ListRef> m_flagWriteTypeLists;
+		ListRef m_flagConditionLists[LLFC_NO + 1];
+		ListRef m_allRegisters, m_fullWidthRegisters, m_globalRegisters, m_allFlags, m_allFlagWriteTypes;
+		bool m_hasRegisters, m_hasFlags, m_hasFlagWriteTypes, m_hasFlagConditions;
+
+		// Every list handed out is a slice of this array, which always holds at least one element
+		std::vector<uint32_t> m_lists;
+
+		ListRef AddList(const uint32_t* values, size_t count);
+		const uint32_t* GetList(const ListRef& list, size_t& count) const;
+
+	public:
+		ArchitectureMetadataTable();
+
+		void SetRegisters(const ArchitectureRegisterEntry* regs, size_t count);
+		void SetFlags(const ArchitectureFlagEntry* flags, size_t count);
+		void SetFlagWriteTypes(const ArchitectureFlagWriteTypeEntry* writeTypes, size_t count);
+		void SetFlagConditions(const ArchitectureFlagConditionEntry* conditions, size_t count);
+
+		template <size_t N> void SetRegisters(const ArchitectureRegisterEntry (&regs)[N]) { SetRegisters(regs, N); }
+		template <size_t N> void SetFlags(const ArchitectureFlagEntry (&flags)[N]) { SetFlags(flags, N); }
+		template <size_t N> void SetFlagWriteTypes(const ArchitectureFlagWriteTypeEntry (&writeTypes)[N])
+		{
+			SetFlagWriteTypes(writeTypes, N);
+		}
+		template <size_t N> void SetFlagConditions(const ArchitectureFlagConditionEntry (&conditions)[N])
+		{
+			SetFlagConditions(conditions, N);
+		}
+
+		bool HasRegisters() const { return m_hasRegisters; }
+		bool HasFlags() const { return m_hasFlags; }
+		bool HasFlagWriteTypes() const { return m_hasFlagWriteTypes; }
+		bool HasFlagConditions() const { return m_hasFlagConditions; }
+
+		const ArchitectureRegisterEntry* GetRegister(uint32_t reg) const;
+		const ArchitectureFlagEntry* GetFlag(uint32_t flag) const;
+		const ArchitectureFlagWriteTypeEntry* GetFlagWriteType(uint32_t writeType) const;
+
+		/*! The list accessors return pointers into storage owned by the table, valid for its lifetime. */
+		const uint32_t* GetAllRegisters(size_t& count) const { return GetList(m_allRegisters, count); }
+		const uint32_t* GetFullWidthRegisters(size_t& count) const { return GetList(m_fullWidthRegisters, count); }
+		const uint32_t* GetGlobalRegisters(size_t& count) const { return GetList(m_globalRegisters, count); }
+		const uint32_t* GetAllFlags(size_t& count) const { return GetList(m_allFlags, count); }
+		const uint32_t* GetAllFlagWriteTypes(size_t& count) const { return GetList(m_allFlagWriteTypes, count); }
+		const uint32_t* GetFlagsRequiredForFlagCondition(BNLowLevelILFlagCondition cond, size_t& count) const;
+		const uint32_t* GetFlagsWrittenByFlagWriteType(uint32_t writeType, size_t& count) const;
+
+		bool IsTableList(const uint32_t* list) const;
+	};
+
 	class LowLevelILFunction;
+	class LowLevelILSnapshot;
 	class FunctionRecognizer;
 	class CallingConvention;
 
 	typedef size_t ExprId;
 
+	/*!
+		LowLevelILLiftCache records the LLIL an architecture emits for an instruction and replays it when the same
+		bytes are lifted again, instead of calling GetInstructionLowLevelIL. Patterns are keyed on the bytes of the
+		decoded instruction only, so the instructions that follow it do not affect lookups. The first time a
+		pattern is seen, it is lifted twice more into a scratch function: at an address shifted by a multiple of
+		the granularity, and at an address that also differs in the top address bit. Operands that are equal in
+		every lift are stored as constants, and operands that differ by exactly the shift in both are stored
+		relative to the instruction address. Lifts with any other difference, such as operands computed from the
+		high bits of the address, are marked uncacheable, as are lifts that use labels, operand lists or
+		expressions that were not created by the lift.
+
+		Templates are only shared between addresses with the same offset modulo the granularity, which keeps
+		page-relative address computations correct with the default of 0x1000. Lifters whose output depends on
+		anything other than the bytes and the address, such as the owning function, must not use this cache.
+	*/
+	class LowLevelILLiftCache
+	{
+		enum OperandKind
+		{
+			ConstantOperand,
+			ExprOperand,
+			RelativeOperand,
+			MaskedRelativeOperand
+		};
+
+		struct Expr
+		{
+			BNLowLevelILOperation operation;
+			size_t size;
+			uint32_t flags;
+			uint32_t sourceOperand;
+			uint64_t addressOffset;
+			uint64_t operands[4];
+			uint8_t kinds[4];
+		};
+
+		struct Key
+		{
+			uint64_t hash;
+			size_t length;
+			uint64_t offset;
+
+			bool operator==(const Key& other) const
+			{
+				return (hash == other.hash) && (length == other.length) && (offset == other.offset);
+			}
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const
+			{
+				return (size_t)(key.hash ^ (key.offset * 0x9e3779b97f4a7c15ULL));
+			}
+		};
+
+		struct Template
+		{
+			Key key;
+			std::vector<uint8_t> bytes;
+			uint64_t address;
+			bool cacheable;
+			bool result;
+			size_t length;
+			std::vector<Expr> exprs;
+			std::vector<size_t> instructions;
+		};
+
+		struct Shard
+		{
+			std::mutex mutex;
+			std::list<std::shared_ptr<const Template>> entries;
+			std::unordered_map<Key, std::list<std::shared_ptr<const Template>>::iterator, KeyHash> index;
+		};
+
+		static constexpr size_t ShardCount = 16;
+
+		Shard m_shards[ShardCount];
+		std::atomic<size_t> m_shardCapacity;
+		size_t m_maxInstructionLength;
+		uint64_t m_addressMask;
+		uint64_t m_granularity;
+		uint64_t m_shift, m_highShift;
+		std::atomic<uint64_t> m_hits, m_misses, m_uncacheable;
+
+		Key GetKey(const uint8_t* data, uint64_t addr, size_t len) const;
+		Shard& GetShard(const Key& key);
+		std::shared_ptr<const Template> Find(const Key& key, const uint8_t* data);
+		void Store(const std::shared_ptr<const Template>& lift);
+
+		bool Capture(LowLevelILFunction& il, uint64_t addr, size_t startExpr, size_t startInstr, Template& result);
+		bool Merge(Template& lift, const Template& shifted, uint64_t shift, bool classify) const;
+		bool Verify(Architecture* arch, const uint8_t* data, uint64_t addr, uint64_t shift, size_t maxLen,
+			Template& lift, bool classify);
+		void Replay(const Template& lift, uint64_t addr, LowLevelILFunction& il) const;
+
+	public:
+		LowLevelILLiftCache(size_t maxInstructionLength, size_t addressSize, size_t maxEntries,
+			uint64_t granularity = 0x1000);
+
+		void SetCapacity(size_t maxEntries);
+		size_t GetCapacity() const;
+		size_t GetEntryCount();
+		uint64_t GetGranularity() const { return m_granularity; }
+
+		/*! GetInstructionLowLevelIL appends the LLIL for the instruction at addr to il, either from a recorded
+		    template or by calling arch->GetInstructionLowLevelIL and recording the result. */
+		bool GetInstructionLowLevelIL(Architecture* arch, const uint8_t* data, uint64_t addr, size_t& len,
+			LowLevelILFunction& il);
+
+		void Invalidate();
+
+		uint64_t GetHitCount() const { return m_hits; }
+		uint64_t GetMissCount() const { return m_misses; }
+		uint64_t GetUncacheableCount() const { return m_uncacheable; }
+		void ResetCounters();
+	};
+
 	/*!
 		The Architecture class is the base class for all CPU architectures. This provides disassembly, assembly,
 		patching, and IL translation lifting for a given architecture.
+
+		Analysis decodes and lifts instructions from many threads at once, and the core already calls
+		GetInstructionInfo, GetInstructionText, GetInstructionLowLevelIL, GetFlagWriteLowLevelIL and
+		GetFlagConditionLowLevelIL concurrently, across functions, for every architecture. Architectures are
+		therefore treated as reentrant and need no flag to be lifted in parallel. Architectures whose decoding
+		and lifting methods are not safe to call concurrently can return true from RequiresSerializedCallbacks,
+		and the API wrapper then serializes those calls for that architecture only.
 	*/
 	class Architecture: public StaticCoreRefCountObject<BNArchitecture>
 	{
 	protected:
 		std::string m_nameForRegister;
 
+		ArchitectureMetadataTable m_metadata;
+
+		std::recursive_mutex m_callbackMutex;
+		std::mutex m_cacheMutex;
+		std::unique_ptr<InstructionDecodeCache> m_decodeCacheStorage;
+		std::atomic<InstructionDecodeCache*> m_decodeCache;
+		std::unique_ptr<LowLevelILLiftCache> m_liftCacheStorage;
+		std::atomic<LowLevelILLiftCache*> m_liftCache;
+		struct ScratchFunction
+		{
+			std::weak_ptr<char> thread;
+			Ref<LowLevelILFunction> func;
+		};
+		std::mutex m_scratchMutex;
+		std::unordered_map<std::thread::id, ScratchFunction> m_scratchFunctions;
+
 		Architecture(BNArchitecture* arch);
 
 		static void InitCallback(void* ctxt, BNArchitecture* obj);
@@ -1644,8 +2400,75 @@ namespace BinaryNinja
 		virtual bool GetInstructionText(const uint8_t* data, uint64_t addr, size_t& len,
 		                                std::vector<InstructionTextToken>& result) = 0;
 
-		/*! GetInstructionLowLevelIL
-			Translates an instruction at addr and appends it onto the LowLevelILFunction& il.
+		/*! EnableDecodeCache
+			Places a bounded InstructionDecodeCache in front of GetInstructionInfo and GetInstructionText, so that
+			repeated decodes of the same bytes at the same address (linear disassembly, instruction length queries,
+			reanalysis) do not call back into the decoder. Calling it again resizes the existing cache.
+			\param maxEntries maximum number of decoded instructions to keep
+		*/
+		void EnableDecodeCache(size_t maxEntries = 65536);
+		void DisableDecodeCache();
+
+		/*! GetDecodeCache returns the active decode cache for reading counters or registering an
+		    InstructionDecodeCache::Invalidator, or nullptr if caching is disabled. */
+		InstructionDecodeCache* GetDecodeCache() const { return m_decodeCache; }
+
+		/*! EnableLiftingCache
+			Places a LowLevelILLiftCache in front of GetInstructionLowLevelIL, so that repeated byte patterns
+			(inlined stubs, thunks, common prologues) are lifted once and replayed afterwards. Calling it again
+			resizes the existing cache; the granularity is fixed by the first call.
+			\param maxEntries maximum number of lifted byte patterns to keep
+			\param granularity address alignment that lifted templates are shared across
+		*/
+		void EnableLiftingCache(size_t maxEntries = 65536, uint64_t granularity = 0x1000);
+		void DisableLiftingCache();
+		LowLevelILLiftCache* GetLiftingCache() const { return m_liftCache; }
+
+		/*! GetCachedInstructionInfo calls GetInstructionInfo the way the core does, through the decode cache when
+		    one is enabled and serialized when RequiresSerializedCallbacks returns true. */
+		bool GetCachedInstructionInfo(const uint8_t* data, uint64_t addr, size_t maxLen, InstructionInfo& result);
+
+		/*! RequiresSerializedCallbacks
+			Architectures that keep unsynchronized mutable state in their decoding and lifting methods can
+			override this to return true, so that the wrapper holds a per-architecture lock around each of those
+			callbacks. The lock is held while the architecture runs, so it must not wait on analysis from inside
+			them. The result must not change after the architecture is registered.
+		*/
+		virtual bool RequiresSerializedCallbacks() const;
+
+		/*! GetScratchLowLevelILFunction
+			Returns a LowLevelILFunction private to the calling thread, for lifting instructions outside of a
+			function being analyzed without creating a new IL function each time. Expressions added to it remain
+			valid only until the next call on the same thread, which may replace it with an empty function.
+			Scratch functions are owned by the architecture object and freed with it, and the functions of
+			threads that have exited are freed the next time another thread needs a new one.
+		*/
+		Ref<LowLevelILFunction> GetScratchLowLevelILFunction();
+
+		/*! GetInstructionInfoBatch
+			Decodes consecutive instructions starting at addr until len bytes have been consumed, maxCount
+			instructions have been decoded, or an instruction fails to decode. The default implementation calls
+			GetInstructionInfo for each instruction; architectures that can decode in bulk should override it.
+			\param data pointer to the instruction data
+			\param addr address of the first instruction
+			\param len number of bytes available at data
+			\param result batch that is cleared and then filled with the decoded instructions
+			\param maxCount maximum number of instructions to decode
+			\return the number of instructions decoded
+		*/
+		virtual size_t GetInstructionInfoBatch(const uint8_t* data, uint64_t addr, size_t len,
+			InstructionInfoBatch& result, size_t maxCount = (size_t)-1);
+
+		/*! GetInstructionTextBatch
+			Disassembles consecutive instructions starting at addr, following the same rules as
+			GetInstructionInfoBatch. The default implementation calls GetInstructionText for each instruction.
+			\return the number of instructions disassembled
+		*/
+		virtual size_t GetInstructionTextBatch(const uint8_t* data, uint64_t addr, size_t len,
+			InstructionTextBatch& result, size_t maxCount = (size_t)-1);
+
+		/*! GetInstructionLowLevelIL
+			Translates an instruction at addr and appends it onto the LowLevelILFunction& il.
 			\param data pointer to the instruction data to be translated
 			\param addr address of the instruction data to be translated
 			\param len length of the instruction data to be translated
@@ -2147,6 +2970,7 @@ namespace BinaryNinja
 		Function(BNFunction* func);
 		virtual ~Function();
 
+		Ref<BinaryView> GetView() const;
 		Ref<Architecture> GetArchitecture() const;
 		Ref<Platform> GetPlatform() const;
 		uint64_t GetStart() const;
@@ -2158,6 +2982,7 @@ namespace BinaryNinja
 
 		std::vector<Ref<BasicBlock>> GetBasicBlocks() const;
 		Ref<BasicBlock> GetBasicBlockAtAddress(Architecture* arch, uint64_t addr) const;
+		CFGSnapshot GetCFGSnapshot();
 		void MarkRecentUse();
 
 		std::string GetComment() const;
@@ -2268,6 +3093,10 @@ namespace BinaryNinja
 
 		void Reanalyze();
 
+		/*! GetLoopInfo returns the natural loops of the function from the LoopInfoCache shared by every user of
+		    its view, so the loops are computed once per analysis update of the function. */
+		std::shared_ptr<const LoopInfo> GetLoopInfo();
+
 		void RequestAdvancedAnalysisData();
 		void ReleaseAdvancedAnalysisData();
 		void ReleaseAdvancedAnalysisData(size_t count);
@@ -2287,13 +3116,607 @@ namespace BinaryNinja
 	public:
 		AdvancedFunctionAnalysisDataRequestor(Function* func = nullptr);
 		AdvancedFunctionAnalysisDataRequestor(const AdvancedFunctionAnalysisDataRequestor& req);
+		AdvancedFunctionAnalysisDataRequestor(AdvancedFunctionAnalysisDataRequestor&& req);
 		~AdvancedFunctionAnalysisDataRequestor();
 		AdvancedFunctionAnalysisDataRequestor& operator=(const AdvancedFunctionAnalysisDataRequestor& req);
+		AdvancedFunctionAnalysisDataRequestor& operator=(AdvancedFunctionAnalysisDataRequestor&& req);
 
 		Ref<Function> GetFunction() { return m_func; }
 		void SetFunction(Function* func);
 	};
 
+	/*!
+		CFGSnapshot is a flat copy of the control flow graph of a function. Blocks are identified by their block
+		index and edges by their position in the edge arrays. Edges are grouped by source block in compressed
+		sparse row form, and each edge has its target, branch type and back edge flag stored as plain integers.
+		The incoming edges of each block are available through a second offset array that lists edge indices.
+
+		Edges whose target is not a block of the function, such as unresolved branches, have NoBlock as target
+		and do not appear as incoming edges.
+	*/
+	class CFGSnapshot
+	{
+		std::vector<Ref<BasicBlock>> m_blocks;
+		std::vector<uint64_t> m_starts, m_ends;
+		std::vector<uint32_t> m_outgoingOffsets;
+		std::vector<uint32_t> m_sources, m_targets;
+		std::vector<uint8_t> m_types, m_backEdges;
+		std::vector<uint32_t> m_incomingOffsets, m_incomingEdges, m_predecessors;
+
+	public:
+		static const uint32_t NoBlock = 0xffffffff;
+
+		CFGSnapshot(Function* func);
+
+		size_t GetBlockCount() const { return m_blocks.size(); }
+		size_t GetEdgeCount() const { return m_targets.size(); }
+		const Ref<BasicBlock>& GetBlock(size_t block) const { return m_blocks[block]; }
+
+		const uint64_t* GetBlockStarts() const { return m_starts.data(); }
+		const uint64_t* GetBlockEnds() const { return m_ends.data(); }
+
+		/*! Edge arrays are indexed by edge. The outgoing edges of block i are the range
+		    [GetOutgoingEdgeOffsets()[i], GetOutgoingEdgeOffsets()[i + 1]). Types are BNBranchType values. */
+		const uint32_t* GetOutgoingEdgeOffsets() const { return m_outgoingOffsets.data(); }
+		const uint32_t* GetEdgeSources() const { return m_sources.data(); }
+		const uint32_t* GetEdgeTargets() const { return m_targets.data(); }
+		const uint8_t* GetEdgeTypes() const { return m_types.data(); }
+		const uint8_t* GetBackEdgeFlags() const { return m_backEdges.data(); }
+
+		/*! The incoming edges of block i are the edge indices in the range
+		    [GetIncomingEdgeOffsets()[i], GetIncomingEdgeOffsets()[i + 1]) of GetIncomingEdges(). */
+		const uint32_t* GetIncomingEdgeOffsets() const { return m_incomingOffsets.data(); }
+		const uint32_t* GetIncomingEdges() const { return m_incomingEdges.data(); }
+
+		/*! GetSuccessors returns the targets of the outgoing edges of a block, which may include NoBlock */
+		const uint32_t* GetSuccessors(size_t block, size_t& count) const
+		{
+			count = m_outgoingOffsets[block + 1] - m_outgoingOffsets[block];
+			return m_targets.data() + m_outgoingOffsets[block];
+		}
+		const uint32_t* GetPredecessors(size_t block, size_t& count) const
+		{
+			count = m_incomingOffsets[block + 1] - m_incomingOffsets[block];
+			return m_predecessors.data() + m_incomingOffsets[block];
+		}
+	};
+
+	/*!
+		DominatorTree exports the dominator relation of every basic block in a function at once. Blocks are
+		identified by their block index. The tree holds the immediate dominator of each block, the children of
+		each block in compressed sparse row form, and pre and post order numbers that answer dominance tests in
+		constant time. Dominance frontiers are stored as bitsets over block indices of GetBitsetWords() words.
+		The control flow edges used to compute the frontiers are kept as successor and predecessor arrays.
+
+		Blocks without an immediate dominator, such as the entry block and unreachable blocks, are roots, so a
+		block only dominates blocks in its own tree.
+	*/
+	class DominatorTree
+	{
+		std::vector<Ref<BasicBlock>> m_blocks;
+		std::vector<uint32_t> m_immediateDominators;
+		std::vector<uint32_t> m_successorOffsets, m_successors;
+		std::vector<uint32_t> m_predecessorOffsets, m_predecessors;
+		std::vector<uint32_t> m_childOffsets, m_children;
+		std::vector<uint32_t> m_preorder, m_postorder;
+		size_t m_bitsetWords;
+		std::vector<uint64_t> m_frontiers;
+
+		void Build(const CFGSnapshot& cfg);
+
+	public:
+		static const uint32_t NoBlock = 0xffffffff;
+
+		DominatorTree(Function* func);
+		DominatorTree(const CFGSnapshot& cfg);
+
+		size_t GetBlockCount() const { return m_blocks.size(); }
+		const Ref<BasicBlock>& GetBlock(size_t block) const { return m_blocks[block]; }
+
+		const uint32_t* GetSuccessors(size_t block, size_t& count) const
+		{
+			count = m_successorOffsets[block + 1] - m_successorOffsets[block];
+			return m_successors.data() + m_successorOffsets[block];
+		}
+		const uint32_t* GetPredecessors(size_t block, size_t& count) const
+		{
+			count = m_predecessorOffsets[block + 1] - m_predecessorOffsets[block];
+			return m_predecessors.data() + m_predecessorOffsets[block];
+		}
+
+		uint32_t GetImmediateDominator(size_t block) const { return m_immediateDominators[block]; }
+		const uint32_t* GetImmediateDominators() const { return m_immediateDominators.data(); }
+		const uint32_t* GetChildren(size_t block, size_t& count) const
+		{
+			count = m_childOffsets[block + 1] - m_childOffsets[block];
+			return m_children.data() + m_childOffsets[block];
+		}
+
+		uint32_t GetPreorderIndex(size_t block) const { return m_preorder[block]; }
+		uint32_t GetPostorderIndex(size_t block) const { return m_postorder[block]; }
+		bool Dominates(size_t dominator, size_t block) const
+		{
+			return (m_preorder[dominator] <= m_preorder[block]) && (m_postorder[block] <= m_postorder[dominator]);
+		}
+		bool StrictlyDominates(size_t dominator, size_t block) const
+		{
+			return (dominator != block) && Dominates(dominator, block);
+		}
+
+		size_t GetBitsetWords() const { return m_bitsetWords; }
+		const uint64_t* GetDominanceFrontier(size_t block) const { return m_frontiers.data() + (block * m_bitsetWords); }
+		bool IsInDominanceFrontier(size_t block, size_t member) const
+		{
+			return (GetDominanceFrontier(block)[member / 64] >> (member % 64)) & 1;
+		}
+
+		/*! GetIteratedDominanceFrontier returns the bitset of blocks in the iterated dominance frontier of a set
+		    of blocks, as needed for phi placement. */
+		std::vector<uint64_t> GetIteratedDominanceFrontier(const std::vector<size_t>& blocks) const;
+	};
+
+	/*!
+		LoopInfo is the loop nesting forest of a function, built from the natural loops of its dominator tree.
+		Back edges that share a header form a single loop. Each loop has a header, the sources of its back
+		edges, its parent loop and nesting depth, the edges leaving it, and a body stored as a bitset over block
+		indices of GetBitsetWords() words. Loops are ordered so that a parent always precedes its children.
+
+		Cycles that are entered at more than one block have no header that dominates them, so they are not
+		reported as loops.
+	*/
+	class LoopInfo
+	{
+	public:
+		static const uint32_t NoLoop = 0xffffffff;
+
+		struct Loop
+		{
+			uint32_t header;
+			uint32_t parent;
+			uint32_t depth;
+			std::vector<uint32_t> backEdgeSources;
+			std::vector<std::pair<uint32_t, uint32_t>> exits;
+		};
+
+	private:
+		std::vector<Ref<BasicBlock>> m_blocks;
+		size_t m_bitsetWords;
+		std::vector<Loop> m_loops;
+		std::vector<uint64_t> m_bodies;
+		std::vector<uint32_t> m_innermostLoops;
+
+		void Build(const DominatorTree& dominators);
+
+	public:
+		LoopInfo(Function* func);
+		LoopInfo(const DominatorTree& dominators);
+
+		size_t GetBlockCount() const { return m_blocks.size(); }
+		const Ref<BasicBlock>& GetBlock(size_t block) const { return m_blocks[block]; }
+
+		size_t GetLoopCount() const { return m_loops.size(); }
+		const Loop& GetLoop(size_t loop) const { return m_loops[loop]; }
+
+		size_t GetBitsetWords() const { return m_bitsetWords; }
+		const uint64_t* GetBody(size_t loop) const { return m_bodies.data() + (loop * m_bitsetWords); }
+		bool Contains(size_t loop, size_t block) const { return (GetBody(loop)[block / 64] >> (block % 64)) & 1; }
+
+		/*! GetInnermostLoop returns the innermost loop containing a block, or NoLoop */
+		uint32_t GetInnermostLoop(size_t block) const { return m_innermostLoops[block]; }
+		uint32_t GetLoopDepth(size_t block) const
+		{
+			uint32_t loop = m_innermostLoops[block];
+			return (loop == NoLoop) ? 0 : m_loops[loop].depth;
+		}
+		bool IsLoopHeader(size_t block) const
+		{
+			uint32_t loop = m_innermostLoops[block];
+			return (loop != NoLoop) && (m_loops[loop].header == block);
+		}
+	};
+
+	/*!
+		LoopInfoCache keeps the LoopInfo of the functions of a view. Loops are computed the first time a function
+		is queried and kept until analysis updates or removes it, so queries between updates share one LoopInfo
+		whichever Function object they are made through. A single notification serves every function.
+
+		GetForView returns the cache that Function::GetLoopInfo uses, shared by every plugin. It does not keep the
+		view alive and is destroyed with the view.
+	*/
+	class LoopInfoCache
+	{
+		class UpdateTracker: public BinaryDataNotification
+		{
+			LoopInfoCache* m_cache;
+
+		public:
+			UpdateTracker(LoopInfoCache* cache): m_cache(cache) {}
+			virtual void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+			virtual void OnAnalysisFunctionUpdated(BinaryView* view, Function* func) override;
+		};
+
+		struct Entry
+		{
+			Ref<Function> func;
+			std::shared_ptr<const LoopInfo> loops;
+			uint64_t version;
+		};
+
+		BNBinaryView* m_view;
+		Ref<BinaryView> m_viewRef;
+		std::unique_ptr<UpdateTracker> m_tracker;
+		std::mutex m_mutex;
+		std::unordered_map<BNFunction*, Entry> m_entries;
+
+		LoopInfoCache(BNBinaryView* view);
+
+		void Update(Function* func);
+		void Remove(Function* func);
+
+		static void DestructBinaryViewCallback(void* ctxt, BNBinaryView* view);
+
+	public:
+		LoopInfoCache(BinaryView* view);
+		~LoopInfoCache();
+
+		static std::shared_ptr<LoopInfoCache> GetForView(BinaryView* view);
+
+		std::shared_ptr<const LoopInfo> GetLoopInfo(Function* func);
+
+		/*! Invalidate discards the stored loops, so every function is recomputed on its next query */
+		void Invalidate();
+	};
+
+	/*!
+		BasicBlockIndex is an immutable snapshot of the address range of every basic block in a view, sorted by
+		start address, together with the function that owns each block. Blocks may overlap, so a lookup can
+		return several ranges. Range queries are answered with two binary searches, without calling into the core.
+	*/
+	class BasicBlockIndex
+	{
+	public:
+		struct Range
+		{
+			uint64_t start, end;
+			size_t function;
+			size_t block;
+		};
+
+	private:
+		std::vector<Ref<Function>> m_functions;
+		std::vector<Ref<BasicBlock>> m_blocks;
+		std::vector<Range> m_ranges;
+
+		// Running maximum of the range ends, which makes the ranges overlapping a query a contiguous run
+		std::vector<uint64_t> m_maxEnd;
+
+		void AddFunctionBlocks(size_t function, std::vector<Range>& ranges);
+		void ComputeMaxEnd();
+		void GetCandidates(uint64_t start, uint64_t end, size_t& first, size_t& last) const;
+
+	public:
+		BasicBlockIndex(BinaryView* view);
+
+		/*! Builds a copy of base in which the blocks of the updated and removed functions are replaced by the
+		    current blocks of the updated functions. Only the updated functions are queried from the core. */
+		BasicBlockIndex(const BasicBlockIndex& base, const std::vector<Ref<Function>>& updated,
+			const std::vector<BNFunction*>& removed);
+
+		size_t GetFunctionCount() const { return m_functions.size(); }
+		size_t GetBlockCount() const { return m_blocks.size(); }
+		const Ref<Function>& GetFunction(size_t i) const { return m_functions[i]; }
+		const Ref<BasicBlock>& GetBlock(size_t i) const { return m_blocks[i]; }
+		const std::vector<Range>& GetRanges() const { return m_ranges; }
+
+		/*! ForEachOverlapping calls func with every range intersecting [start, end), in order of start address. */
+		template <typename T>
+		void ForEachOverlapping(uint64_t start, uint64_t end, const T& func) const
+		{
+			size_t first, last;
+			GetCandidates(start, end, first, last);
+			for (size_t i = first; i < last; i++)
+			{
+				if (m_ranges[i].end > start)
+					func(m_ranges[i]);
+			}
+		}
+
+		/*! ForEachContaining calls func with every range containing addr. */
+		template <typename T>
+		void ForEachContaining(uint64_t addr, const T& func) const
+		{
+			ForEachOverlapping(addr, addr + 1, func);
+		}
+
+		/*! GetRangeForAddress returns the range with the highest start address containing addr, or nullptr. It
+		    does not allocate. */
+		const Range* GetRangeForAddress(uint64_t addr) const;
+
+		std::vector<Ref<Function>> GetFunctionsInRange(uint64_t start, uint64_t end) const;
+		std::vector<Ref<Function>> GetFunctionsForAddress(uint64_t addr) const;
+		std::vector<Ref<BasicBlock>> GetBasicBlocksForAddress(uint64_t addr) const;
+	};
+
+	/*!
+		BasicBlockIndexCache keeps a BasicBlockIndex for a view. The functions that analysis adds, removes or
+		updates are queued, and the next request patches only their blocks into a new index instead of
+		rebuilding it from every function. Indexes that were handed out stay valid and unchanged, so lookups can
+		continue on other threads while a new one is built.
+	*/
+	class BasicBlockIndexCache
+	{
+		class UpdateTracker: public BinaryDataNotification
+		{
+			BasicBlockIndexCache* m_cache;
+
+		public:
+			UpdateTracker(BasicBlockIndexCache* cache): m_cache(cache) {}
+			virtual void OnAnalysisFunctionAdded(BinaryView* view, Function* func) override;
+			virtual void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+			virtual void OnAnalysisFunctionUpdated(BinaryView* view, Function* func) override;
+		};
+
+		Ref<BinaryView> m_view;
+		std::unique_ptr<UpdateTracker> m_tracker;
+		std::mutex m_mutex;
+		std::shared_ptr<const BasicBlockIndex> m_index;
+		std::atomic<bool> m_populated;
+
+		std::mutex m_pendingMutex;
+		std::unordered_map<BNFunction*, Ref<Function>> m_pendingUpdates;
+		std::unordered_map<BNFunction*, Ref<Function>> m_pendingRemovals;
+
+		void QueueUpdate(Function* func);
+		void QueueRemoval(Function* func);
+
+	public:
+		BasicBlockIndexCache(BinaryView* view);
+		~BasicBlockIndexCache();
+
+		std::shared_ptr<const BasicBlockIndex> GetIndex();
+
+		/*! Invalidate discards the index, so the next request rebuilds it from every function */
+		void Invalidate();
+	};
+
+	/*! CodeReference is a single code cross reference: the instruction at from, in func and decoded with arch,
+	    refers to the address to. */
+	struct CodeReference
+	{
+		Ref<Architecture> arch;
+		uint64_t from;
+		Ref<Function> func;
+		uint64_t to;
+	};
+
+	/*!
+		CodeReferenceTable is a flat export of every code reference whose target lies in a range of a view. The
+		records hold indices into the architecture and function tables rather than references, and are sorted by
+		source address, then target address.
+
+		The core only reports the sources of references into a range, so targets are located by splitting ranges
+		that contain references into smaller parts until they can be queried address by address. Ranges without
+		references cost a single query regardless of their size.
+	*/
+	class CodeReferenceTable
+	{
+	public:
+		struct Record
+		{
+			uint64_t from;
+			uint64_t to;
+			uint32_t arch;
+			uint32_t func;
+		};
+
+	private:
+		std::vector<Ref<Architecture>> m_archs;
+		std::vector<Ref<Function>> m_functions;
+		std::vector<Record> m_records;
+
+		void Build(BinaryView* view, uint64_t start, uint64_t end);
+
+	public:
+		CodeReferenceTable(BinaryView* view);
+		CodeReferenceTable(BinaryView* view, uint64_t start, uint64_t len);
+
+		size_t GetCount() const { return m_records.size(); }
+		const std::vector<Record>& GetRecords() const { return m_records; }
+		const Ref<Architecture>& GetArchitecture(size_t i) const { return m_archs[i]; }
+		const Ref<Function>& GetFunction(size_t i) const { return m_functions[i]; }
+		size_t GetArchitectureCount() const { return m_archs.size(); }
+		size_t GetFunctionCount() const { return m_functions.size(); }
+		CodeReference GetReference(size_t i) const;
+	};
+
+	/*! CodeReferenceCursor streams the code references of a view in order of target address and then source
+	    address, so that only one batch is held in memory. The references to a single target are never split
+	    across batches, so a batch can exceed the batch size by the references of its last target. */
+	class CodeReferenceCursor: public BatchCursor<CodeReference>
+	{
+		Ref<BinaryView> m_view;
+		uint64_t m_next, m_end, m_window;
+
+	protected:
+		virtual bool FetchBatch(std::vector<CodeReference>& batch) override;
+
+	public:
+		CodeReferenceCursor(BinaryView* view, size_t batchSize = 4096);
+		CodeReferenceCursor(BinaryView* view, uint64_t start, uint64_t len, size_t batchSize = 4096);
+	};
+
+	/*!
+		IncrementalAnalysis tracks the byte ranges modified in a view through BinaryDataNotification and, when
+		asked, queues reanalysis of only the functions with basic blocks overlapping those ranges. Changes that
+		arrive while Reanalyze is running are kept for the next call.
+	*/
+	class IncrementalAnalysis
+	{
+		class ChangeTracker: public BinaryDataNotification
+		{
+			IncrementalAnalysis* m_analysis;
+
+		public:
+			ChangeTracker(IncrementalAnalysis* analysis): m_analysis(analysis) {}
+			virtual void OnBinaryDataWritten(BinaryView* view, uint64_t offset, size_t len) override;
+			virtual void OnBinaryDataInserted(BinaryView* view, uint64_t offset, size_t len) override;
+			virtual void OnBinaryDataRemoved(BinaryView* view, uint64_t offset, uint64_t len) override;
+		};
+
+		Ref<BinaryView> m_view;
+		std::unique_ptr<ChangeTracker> m_tracker;
+		BasicBlockIndexCache m_index;
+		std::mutex m_mutex;
+		std::vector<std::pair<uint64_t, uint64_t>> m_dirty;
+
+		std::vector<std::pair<uint64_t, uint64_t>> TakeDirtyRanges();
+		std::vector<Ref<Function>> GetFunctionsForRanges(const std::vector<std::pair<uint64_t, uint64_t>>& ranges);
+
+	public:
+		IncrementalAnalysis(BinaryView* view);
+		~IncrementalAnalysis();
+
+		void MarkDirty(uint64_t offset, uint64_t len);
+		bool HasPendingChanges();
+
+		/*! GetDirtyFunctions returns the functions that Reanalyze would queue, without clearing the changes. */
+		std::vector<Ref<Function>> GetDirtyFunctions();
+
+		/*! Reanalyze queues every function overlapping a modified range for reanalysis and clears the tracked
+		    changes. If updateAnalysis is true and any function was queued, analysis is started.
+		    \return the number of functions that were queued
+		*/
+		size_t Reanalyze(bool updateAnalysis = true);
+	};
+
+	/*!
+		CallGraph is an immutable whole-program call graph. Nodes are analysis functions numbered in order of
+		start address. Edges are stored in compressed sparse row form in both directions, so the callees and
+		callers of a node are each a contiguous, sorted array of node indices.
+
+		An edge is created for every call or jump to a constant address in the low level IL of a function that
+		lands on the start of a function. Indirect calls that analysis has not resolved to a constant have no edge.
+	*/
+	class CallGraph
+	{
+	public:
+		struct FunctionCalls
+		{
+			Ref<Function> func;
+			std::vector<uint64_t> targets;
+		};
+
+	private:
+		std::vector<Ref<Function>> m_functions;
+		std::vector<uint64_t> m_starts;
+		std::unordered_map<BNFunction*, uint32_t> m_nodes;
+		std::vector<uint32_t> m_calleeOffsets, m_callees;
+		std::vector<uint32_t> m_callerOffsets, m_callers;
+
+		void Build(std::vector<const FunctionCalls*> functions);
+
+	public:
+		CallGraph(BinaryView* view);
+		CallGraph(const std::vector<const FunctionCalls*>& functions);
+
+		/*! GetCallTargets returns the sorted, unique constant call and jump targets in a function's low level IL */
+		static std::vector<uint64_t> GetCallTargets(Function* func);
+
+		size_t GetNodeCount() const { return m_functions.size(); }
+		size_t GetEdgeCount() const { return m_callees.size(); }
+		const Ref<Function>& GetFunction(size_t node) const { return m_functions[node]; }
+		bool GetNode(Function* func, size_t& node) const;
+
+		const uint32_t* GetCallees(size_t node, size_t& count) const;
+		const uint32_t* GetCallers(size_t node, size_t& count) const;
+		std::vector<Ref<Function>> GetCallees(Function* func) const;
+		std::vector<Ref<Function>> GetCallers(Function* func) const;
+
+		/*! GetStronglyConnectedComponents assigns each node the index of its strongly connected component.
+		    Components are numbered bottom-up: a component only calls into components with lower indices.
+		    \return the number of components
+		*/
+		size_t GetStronglyConnectedComponents(std::vector<uint32_t>& components) const;
+
+		/*! GetBottomUpOrder lists every node after all of its callees, except for calls within a cycle. The
+		    members of each strongly connected component are adjacent. */
+		std::vector<uint32_t> GetBottomUpOrder() const;
+
+		/*! GetTopDownOrder lists every node before all of its callees, except for calls within a cycle. */
+		std::vector<uint32_t> GetTopDownOrder() const;
+	};
+
+	/*!
+		CallGraphCache keeps a CallGraph of a view up to date. Functions that analysis adds or updates are
+		queued, and only their call targets are rescanned when the next graph is requested; the adjacency arrays
+		are then reassembled from the stored targets. Graphs that were handed out are never modified.
+	*/
+	class CallGraphCache
+	{
+		class UpdateTracker: public BinaryDataNotification
+		{
+			CallGraphCache* m_cache;
+
+		public:
+			UpdateTracker(CallGraphCache* cache): m_cache(cache) {}
+			virtual void OnAnalysisFunctionAdded(BinaryView* view, Function* func) override;
+			virtual void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+			virtual void OnAnalysisFunctionUpdated(BinaryView* view, Function* func) override;
+		};
+
+		Ref<BinaryView> m_view;
+		std::unique_ptr<UpdateTracker> m_tracker;
+		std::mutex m_mutex;
+		std::unordered_map<BNFunction*, CallGraph::FunctionCalls> m_calls;
+		std::shared_ptr<const CallGraph> m_graph;
+		std::atomic<bool> m_populated;
+
+		std::mutex m_pendingMutex;
+		std::unordered_map<BNFunction*, Ref<Function>> m_pendingUpdates;
+		std::unordered_map<BNFunction*, Ref<Function>> m_pendingRemovals;
+
+		void QueueUpdate(Function* func);
+		void QueueRemoval(Function* func);
+
+	public:
+		CallGraphCache(BinaryView* view);
+		~CallGraphCache();
+
+		std::shared_ptr<const CallGraph> GetGraph();
+
+		/*! Invalidate discards the stored call targets, so the next graph rescans every function */
+		void Invalidate();
+	};
+
+	/*!
+		DisassemblyTextCache is a process-wide LRU of generated disassembly text, shared by all function graphs
+		and graph layouts. Text is stored under an owner and a key chosen by that owner. Once the estimated size
+		of the stored text exceeds the limit, the least recently used text is dropped, and it is generated again
+		if it is requested later. Text that a caller still holds through a Lines pointer stays alive until the
+		caller releases it.
+	*/
+	class DisassemblyTextCache
+	{
+	public:
+		typedef std::shared_ptr<const std::vector<DisassemblyTextLine>> Lines;
+
+		/*! Lookup returns the stored text and marks it as most recently used, or returns null */
+		static Lines Lookup(const void* owner, uint64_t key);
+		static bool Contains(const void* owner, uint64_t key);
+
+		/*! Store keeps text for a key unless text is already stored for it, evicts least recently used text
+		    while over the limit, and returns the text now stored for the key. */
+		static Lines Store(const void* owner, uint64_t key, const Lines& lines);
+
+		static void Release(const void* owner, uint64_t key);
+		static void ReleaseOwner(const void* owner);
+
+		static void SetLimit(size_t bytes);
+		static size_t GetLimit();
+		static size_t GetUsage();
+		static size_t EstimateSize(const std::vector<DisassemblyTextLine>& lines);
+	};
+
 	struct FunctionGraphEdge
 	{
 		BNBranchType type;
@@ -2305,12 +3728,12 @@ namespace BinaryNinja
 	class FunctionGraphBlock: public CoreRefCountObject<BNFunctionGraphBlock,
 		BNNewFunctionGraphBlockReference, BNFreeFunctionGraphBlock>
 	{
-		std::vector<DisassemblyTextLine> m_cachedLines;
 		std::vector<FunctionGraphEdge> m_cachedEdges;
-		bool m_cachedLinesValid, m_cachedEdgesValid;
+		bool m_cachedEdgesValid;
 
 	public:
 		FunctionGraphBlock(BNFunctionGraphBlock* block);
+		virtual ~FunctionGraphBlock();
 
 		Ref<BasicBlock> GetBasicBlock() const;
 		Ref<Architecture> GetArchitecture() const;
@@ -2321,7 +3744,13 @@ namespace BinaryNinja
 		int GetWidth() const;
 		int GetHeight() const;
 
-		const std::vector<DisassemblyTextLine>& GetLines();
+		/*! GetLines returns the text of the block, generating it when it is not in the DisassemblyTextCache.
+		    The returned pointer keeps the text alive for as long as the caller holds it, even if the cache
+		    evicts it meanwhile. The block itself does not hold the text. */
+		DisassemblyTextCache::Lines GetLines();
+		bool HasLines() const;
+		void ReleaseLines();
+
 		const std::vector<FunctionGraphEdge>& GetOutgoingEdges();
 	};
 
@@ -2358,10 +3787,93 @@ namespace BinaryNinja
 		int GetHeight() const;
 		std::vector<Ref<FunctionGraphBlock>> GetBlocksInRegion(int left, int top, int right, int bottom);
 
+		/*! ReleaseLinesOutsideRegion drops the text of every block that does not intersect a region, such as
+		    blocks that have scrolled out of view. */
+		void ReleaseLinesOutsideRegion(int left, int top, int right, int bottom);
+
 		bool IsOptionSet(BNDisassemblyOption option) const;
 		void SetOption(BNDisassemblyOption option, bool state = true);
 	};
 
+	/*!
+		FunctionGraphLayout is a layered layout of the disassembly graph of a function, computed in the API for
+		callers that only need part of a large graph. Ranks, the order of blocks within each rank, and coordinates
+		are computed from a CFGSnapshot, estimating the height of each block from its instruction count, without
+		generating any text. Blocks are sized in parallel. Ranking and ordering run on one thread per weakly
+		connected part of the graph, and the parts are placed side by side. Disassembly text is generated only
+		when it is requested, for a single block with GetLines or for every block intersecting a region with
+		MaterializeRegion.
+
+		Coordinates are in character cells, one unit per column and one per line. Every block is blockWidth
+		columns wide. MaterializeRegion resizes the blocks in the region to their line count and moves the ranks
+		below them, so coordinates can change after it is called. GetLines does not resize blocks.
+
+		A layout has a single owner. MaterializeRegion modifies the blocks and edges, so it must not run while
+		other threads use the same layout. GetLines and IsMaterialized may be called from several threads.
+	*/
+	class FunctionGraphLayout
+	{
+	public:
+		struct Block
+		{
+			Ref<BasicBlock> block;
+			uint32_t rank;
+			uint32_t component;
+			int x, y, width, height;
+		};
+
+		struct Edge
+		{
+			uint32_t source;
+			uint32_t target;
+			BNBranchType type;
+			bool backEdge;
+			std::vector<BNPoint> points;
+		};
+
+	private:
+		Ref<DisassemblySettings> m_settings;
+		int m_width, m_height;
+		int m_verticalMargin;
+		size_t m_componentCount;
+		std::vector<Block> m_blocks;
+		std::vector<Edge> m_edges;
+
+		void LayoutComponent(const CFGSnapshot& cfg, const std::vector<uint32_t>& blocks,
+			std::vector<uint8_t>& backEdges, std::vector<uint8_t>& state, std::vector<uint32_t>& position,
+			int blockWidth, int horizontalMargin, int& width);
+		void PlaceRanks();
+
+	public:
+		FunctionGraphLayout(Function* func, DisassemblySettings* settings = nullptr, int blockWidth = 60,
+			int horizontalMargin = 4, int verticalMargin = 2, size_t threads = 0);
+		~FunctionGraphLayout();
+
+		int GetWidth() const { return m_width; }
+		int GetHeight() const { return m_height; }
+
+		/*! Blocks are indexed by basic block index */
+		size_t GetBlockCount() const { return m_blocks.size(); }
+		const Block& GetBlock(size_t block) const { return m_blocks[block]; }
+		size_t GetEdgeCount() const { return m_edges.size(); }
+		const Edge& GetEdge(size_t edge) const { return m_edges[edge]; }
+
+		std::vector<uint32_t> GetBlocksInRegion(int left, int top, int right, int bottom) const;
+
+		/*! MaterializeRegion generates the text of every block intersecting a region that does not have it yet,
+		    spread over a pool of worker threads, and returns the blocks in the region. Blocks whose text has a
+		    different line count than estimated are resized and the layout below them is updated, so the result
+		    reflects the region after resizing. */
+		std::vector<uint32_t> MaterializeRegion(int left, int top, int right, int bottom, size_t threads = 0);
+
+		/*! GetLines returns the text of a block. Text is kept in the DisassemblyTextCache, so it may be
+		    generated again after being evicted. */
+		DisassemblyTextCache::Lines GetLines(uint32_t block);
+		bool IsMaterialized(uint32_t block) const;
+		void ReleaseLines();
+		void ReleaseLinesOutsideRegion(int left, int top, int right, int bottom);
+	};
+
 	struct LowLevelILLabel: public BNLowLevelILLabel
 	{
 		LowLevelILLabel();
@@ -2655,8 +4167,112 @@ namespace BinaryNinja
 		size_t GetMediumLevelILExprIndex(size_t expr) const;
 		size_t GetMappedMediumLevelILInstructionIndex(size_t instr) const;
 		size_t GetMappedMediumLevelILExprIndex(size_t expr) const;
+
+		LowLevelILSnapshot GetSnapshot() const;
+	};
+
+	/*! LowLevelILSnapshotExpr is a non-refcounted view of a single expression inside a LowLevelILSnapshot.
+	    It is only valid for as long as the snapshot it was obtained from is alive.
+	*/
+	class LowLevelILSnapshotExpr
+	{
+		const LowLevelILSnapshot* m_snapshot;
+		size_t m_expr;
+
+	public:
+		LowLevelILSnapshotExpr(const LowLevelILSnapshot* snapshot, size_t expr): m_snapshot(snapshot), m_expr(expr) {}
+
+		size_t GetExprIndex() const { return m_expr; }
+		inline BNLowLevelILOperation GetOperation() const;
+		inline size_t GetSize() const;
+		inline uint32_t GetFlags() const;
+		inline uint32_t GetSourceOperand() const;
+		inline uint64_t GetAddress() const;
+		inline uint64_t GetRawOperand(size_t operand) const;
+		inline LowLevelILSnapshotExpr GetRawOperandAsExpr(size_t operand) const;
+
+		LowLevelILInstruction ToInstruction() const;
+	};
+
+	/*! LowLevelILSnapshot is a flat, structure-of-arrays copy of every expression in a LowLevelILFunction.
+	    All of the data is fetched from the core when the snapshot is created, so passes that repeatedly walk
+	    the expression tree can do so without going through the core API for each node. The snapshot does not
+	    track later modifications to the function it was taken from.
+	*/
+	class LowLevelILSnapshot
+	{
+		Ref<LowLevelILFunction> m_function;
+		std::vector<BNLowLevelILOperation> m_operations;
+		std::vector<size_t> m_sizes;
+		std::vector<uint32_t> m_flags;
+		std::vector<uint32_t> m_sourceOperands;
+		std::vector<uint64_t> m_operands;
+		std::vector<uint64_t> m_addresses;
+		std::vector<size_t> m_instructionExprs;
+
+		friend class LowLevelILSnapshotExpr;
+
+	public:
+		static const size_t OperandsPerExpr = 4;
+
+		LowLevelILSnapshot();
+		LowLevelILSnapshot(LowLevelILFunction* func);
+
+		Ref<LowLevelILFunction> GetFunction() const { return m_function; }
+		size_t GetExprCount() const { return m_operations.size(); }
+		size_t GetInstructionCount() const { return m_instructionExprs.size(); }
+
+		LowLevelILSnapshotExpr GetExpr(size_t expr) const { return LowLevelILSnapshotExpr(this, expr); }
+		LowLevelILSnapshotExpr GetInstruction(size_t instr) const
+		{
+			return LowLevelILSnapshotExpr(this, m_instructionExprs[instr]);
+		}
+		size_t GetIndexForInstruction(size_t instr) const { return m_instructionExprs[instr]; }
+
+		const BNLowLevelILOperation* GetOperations() const { return m_operations.data(); }
+		const size_t* GetSizes() const { return m_sizes.data(); }
+		const uint32_t* GetFlags() const { return m_flags.data(); }
+		const uint32_t* GetSourceOperands() const { return m_sourceOperands.data(); }
+		const uint64_t* GetOperands() const { return m_operands.data(); }
+		const uint64_t* GetAddresses() const { return m_addresses.data(); }
+		const size_t* GetInstructionExprs() const { return m_instructionExprs.data(); }
 	};
 
+	inline BNLowLevelILOperation LowLevelILSnapshotExpr::GetOperation() const
+	{
+		return m_snapshot->m_operations[m_expr];
+	}
+
+	inline size_t LowLevelILSnapshotExpr::GetSize() const
+	{
+		return m_snapshot->m_sizes[m_expr];
+	}
+
+	inline uint32_t LowLevelILSnapshotExpr::GetFlags() const
+	{
+		return m_snapshot->m_flags[m_expr];
+	}
+
+	inline uint32_t LowLevelILSnapshotExpr::GetSourceOperand() const
+	{
+		return m_snapshot->m_sourceOperands[m_expr];
+	}
+
+	inline uint64_t LowLevelILSnapshotExpr::GetAddress() const
+	{
+		return m_snapshot->m_addresses[m_expr];
+	}
+
+	inline uint64_t LowLevelILSnapshotExpr::GetRawOperand(size_t operand) const
+	{
+		return m_snapshot->m_operands[(m_expr * LowLevelILSnapshot::OperandsPerExpr) + operand];
+	}
+
+	inline LowLevelILSnapshotExpr LowLevelILSnapshotExpr::GetRawOperandAsExpr(size_t operand) const
+	{
+		return LowLevelILSnapshotExpr(m_snapshot, (size_t)GetRawOperand(operand));
+	}
+
 	struct MediumLevelILLabel: public BNMediumLevelILLabel
 	{
 		MediumLevelILLabel();
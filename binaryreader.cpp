@@ -18,13 +18,69 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data)
+static inline uint16_t DecodeLE16(const uint8_t* data)
+{
+	return (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+}
+
+
+static inline uint32_t DecodeLE32(const uint8_t* data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+static inline uint64_t DecodeLE64(const uint8_t* data)
+{
+	return (uint64_t)DecodeLE32(data) | ((uint64_t)DecodeLE32(data + 4) << 32);
+}
+
+
+static inline uint16_t DecodeBE16(const uint8_t* data)
+{
+	return ((uint16_t)data[0] << 8) | (uint16_t)data[1];
+}
+
+
+static inline uint32_t DecodeBE32(const uint8_t* data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+
+static inline uint64_t DecodeBE64(const uint8_t* data)
+{
+	return ((uint64_t)DecodeBE32(data) << 32) | (uint64_t)DecodeBE32(data + 4);
+}
+
+
+void BinaryReader::WindowInvalidator::OnBinaryDataWritten(BinaryView*, uint64_t, size_t)
+{
+	m_reader->m_windowStale = true;
+}
+
+
+void BinaryReader::WindowInvalidator::OnBinaryDataInserted(BinaryView*, uint64_t, size_t)
+{
+	m_reader->m_windowStale = true;
+}
+
+
+void BinaryReader::WindowInvalidator::OnBinaryDataRemoved(BinaryView*, uint64_t, uint64_t)
+{
+	m_reader->m_windowStale = true;
+}
+
+
+BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data), m_endian(endian),
+	m_buffered(false), m_offset(0), m_windowStart(0), m_windowLength(0), m_windowStale(false)
 {
 	m_stream = BNCreateBinaryReader(data->GetObject());
 	BNSetBinaryReaderEndianness(m_stream, endian);
@@ -33,25 +89,93 @@ BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data)
 
 BinaryReader::~BinaryReader()
 {
+	if (m_invalidator)
+		m_view->UnregisterNotification(m_invalidator.get());
 	BNFreeBinaryReader(m_stream);
 }
 
 
 BNEndianness BinaryReader::GetEndianness() const
 {
-	return BNGetBinaryReaderEndianness(m_stream);
+	return m_endian;
 }
 
 
 void BinaryReader::SetEndianness(BNEndianness endian)
 {
+	m_endian = endian;
 	BNSetBinaryReaderEndianness(m_stream, endian);
 }
 
 
+void BinaryReader::EnableBuffering(size_t windowSize)
+{
+	// The window must be able to hold the largest integer read
+	if (windowSize < sizeof(uint64_t))
+		windowSize = sizeof(uint64_t);
+	if (!m_buffered)
+		m_offset = BNGetReaderPosition(m_stream);
+	m_buffered = true;
+	m_window.resize(windowSize);
+	InvalidateWindow();
+
+	if (!m_invalidator)
+	{
+		m_invalidator.reset(new WindowInvalidator(this));
+		m_view->RegisterNotification(m_invalidator.get());
+	}
+}
+
+
+void BinaryReader::DisableBuffering()
+{
+	if (!m_buffered)
+		return;
+
+	m_view->UnregisterNotification(m_invalidator.get());
+	m_invalidator.reset();
+
+	BNSeekBinaryReader(m_stream, m_offset);
+	m_buffered = false;
+	m_window.clear();
+	m_window.shrink_to_fit();
+	InvalidateWindow();
+}
+
+
+void BinaryReader::InvalidateWindow()
+{
+	m_windowStart = 0;
+	m_windowLength = 0;
+	m_windowStale = false;
+}
+
+
+const uint8_t* BinaryReader::ReadFromWindow(size_t len)
+{
+	if (m_windowStale)
+		InvalidateWindow();
+
+	if ((m_offset < m_windowStart) || ((m_offset - m_windowStart) > m_windowLength) ||
+		(len > (m_windowLength - (m_offset - m_windowStart))))
+	{
+		if (len > m_window.size())
+			return nullptr;
+		m_windowStart = m_offset;
+		m_windowLength = m_view->Read(&m_window[0], m_offset, m_window.size());
+		if (len > m_windowLength)
+			return nullptr;
+	}
+
+	const uint8_t* result = &m_window[(size_t)(m_offset - m_windowStart)];
+	m_offset += len;
+	return result;
+}
+
+
 void BinaryReader::Read(void* dest, size_t len)
 {
-	if (!BNReadData(m_stream, dest, len))
+	if (!TryRead(dest, len))
 		throw ReadException();
 }
 
@@ -64,6 +188,15 @@ DataBuffer BinaryReader::Read(size_t len)
 }
 
 
+DataBufferView BinaryReader::Read(size_t len, DataBuffer& storage)
+{
+	if (storage.GetLength() < len)
+		storage.SetSize(len);
+	Read(storage.GetData(), len);
+	return storage.GetView(0, len);
+}
+
+
 string BinaryReader::ReadString(size_t len)
 {
 	DataBuffer result = Read(len);
@@ -74,7 +207,7 @@ string BinaryReader::ReadString(size_t len)
 uint8_t BinaryReader::Read8()
 {
 	uint8_t result;
-	if (!BNRead8(m_stream, &result))
+	if (!TryRead8(result))
 		throw ReadException();
 	return result;
 }
@@ -83,7 +216,7 @@ uint8_t BinaryReader::Read8()
 uint16_t BinaryReader::Read16()
 {
 	uint16_t result;
-	if (!BNRead16(m_stream, &result))
+	if (!TryRead16(result))
 		throw ReadException();
 	return result;
 }
@@ -92,7 +225,7 @@ uint16_t BinaryReader::Read16()
 uint32_t BinaryReader::Read32()
 {
 	uint32_t result;
-	if (!BNRead32(m_stream, &result))
+	if (!TryRead32(result))
 		throw ReadException();
 	return result;
 }
@@ -101,7 +234,7 @@ uint32_t BinaryReader::Read32()
 uint64_t BinaryReader::Read64()
 {
 	uint64_t result;
-	if (!BNRead64(m_stream, &result))
+	if (!TryRead64(result))
 		throw ReadException();
 	return result;
 }
@@ -110,7 +243,7 @@ uint64_t BinaryReader::Read64()
 uint16_t BinaryReader::ReadLE16()
 {
 	uint16_t result;
-	if (!BNReadLE16(m_stream, &result))
+	if (!TryReadLE16(result))
 		throw ReadException();
 	return result;
 }
@@ -119,7 +252,7 @@ uint16_t BinaryReader::ReadLE16()
 uint32_t BinaryReader::ReadLE32()
 {
 	uint32_t result;
-	if (!BNReadLE32(m_stream, &result))
+	if (!TryReadLE32(result))
 		throw ReadException();
 	return result;
 }
@@ -128,7 +261,7 @@ uint32_t BinaryReader::ReadLE32()
 uint64_t BinaryReader::ReadLE64()
 {
 	uint64_t result;
-	if (!BNReadLE64(m_stream, &result))
+	if (!TryReadLE64(result))
 		throw ReadException();
 	return result;
 }
@@ -137,7 +270,7 @@ uint64_t BinaryReader::ReadLE64()
 uint16_t BinaryReader::ReadBE16()
 {
 	uint16_t result;
-	if (!BNReadBE16(m_stream, &result))
+	if (!TryReadBE16(result))
 		throw ReadException();
 	return result;
 }
@@ -146,7 +279,7 @@ uint16_t BinaryReader::ReadBE16()
 uint32_t BinaryReader::ReadBE32()
 {
 	uint32_t result;
-	if (!BNReadBE32(m_stream, &result))
+	if (!TryReadBE32(result))
 		throw ReadException();
 	return result;
 }
@@ -155,7 +288,7 @@ uint32_t BinaryReader::ReadBE32()
 uint64_t BinaryReader::ReadBE64()
 {
 	uint64_t result;
-	if (!BNReadBE64(m_stream, &result))
+	if (!TryReadBE64(result))
 		throw ReadException();
 	return result;
 }
@@ -163,7 +296,23 @@ uint64_t BinaryReader::ReadBE64()
 
 bool BinaryReader::TryRead(void* dest, size_t len)
 {
-	return BNReadData(m_stream, dest, len);
+	if (!m_buffered)
+		return BNReadData(m_stream, dest, len);
+
+	// Reads larger than the window bypass it entirely
+	if (len > m_window.size())
+	{
+		if (m_view->Read(dest, m_offset, len) != len)
+			return false;
+		m_offset += len;
+		return true;
+	}
+
+	const uint8_t* data = ReadFromWindow(len);
+	if (!data)
+		return false;
+	memcpy(dest, data, len);
+	return true;
 }
 
 
@@ -186,84 +335,154 @@ bool BinaryReader::TryReadString(string& dest, size_t len)
 
 bool BinaryReader::TryRead8(uint8_t& result)
 {
-	return BNRead8(m_stream, &result);
+	if (!m_buffered)
+		return BNRead8(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(1);
+	if (!data)
+		return false;
+	result = *data;
+	return true;
 }
 
 
 bool BinaryReader::TryRead16(uint16_t& result)
 {
-	return BNRead16(m_stream, &result);
+	if (!m_buffered)
+		return BNRead16(m_stream, &result);
+	if (m_endian == LittleEndian)
+		return TryReadLE16(result);
+	return TryReadBE16(result);
 }
 
 
 bool BinaryReader::TryRead32(uint32_t& result)
 {
-	return BNRead32(m_stream, &result);
+	if (!m_buffered)
+		return BNRead32(m_stream, &result);
+	if (m_endian == LittleEndian)
+		return TryReadLE32(result);
+	return TryReadBE32(result);
 }
 
 
 bool BinaryReader::TryRead64(uint64_t& result)
 {
-	return BNRead64(m_stream, &result);
+	if (!m_buffered)
+		return BNRead64(m_stream, &result);
+	if (m_endian == LittleEndian)
+		return TryReadLE64(result);
+	return TryReadBE64(result);
 }
 
 
 bool BinaryReader::TryReadLE16(uint16_t& result)
 {
-	return BNReadLE16(m_stream, &result);
+	if (!m_buffered)
+		return BNReadLE16(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(2);
+	if (!data)
+		return false;
+	result = DecodeLE16(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadLE32(uint32_t& result)
 {
-	return BNReadLE32(m_stream, &result);
+	if (!m_buffered)
+		return BNReadLE32(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(4);
+	if (!data)
+		return false;
+	result = DecodeLE32(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadLE64(uint64_t& result)
 {
-	return BNReadLE64(m_stream, &result);
+	if (!m_buffered)
+		return BNReadLE64(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(8);
+	if (!data)
+		return false;
+	result = DecodeLE64(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadBE16(uint16_t& result)
 {
-	return BNReadBE16(m_stream, &result);
+	if (!m_buffered)
+		return BNReadBE16(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(2);
+	if (!data)
+		return false;
+	result = DecodeBE16(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadBE32(uint32_t& result)
 {
-	return BNReadBE32(m_stream, &result);
+	if (!m_buffered)
+		return BNReadBE32(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(4);
+	if (!data)
+		return false;
+	result = DecodeBE32(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadBE64(uint64_t& result)
 {
-	return BNReadBE64(m_stream, &result);
+	if (!m_buffered)
+		return BNReadBE64(m_stream, &result);
+	const uint8_t* data = ReadFromWindow(8);
+	if (!data)
+		return false;
+	result = DecodeBE64(data);
+	return true;
 }
 
 
 uint64_t BinaryReader::GetOffset() const
 {
+	if (m_buffered)
+		return m_offset;
 	return BNGetReaderPosition(m_stream);
 }
 
 
 void BinaryReader::Seek(uint64_t offset)
 {
+	if (m_buffered)
+	{
+		m_offset = offset;
+		if ((offset < m_windowStart) || ((offset - m_windowStart) >= m_windowLength))
+			InvalidateWindow();
+		return;
+	}
 	BNSeekBinaryReader(m_stream, offset);
 }
 
 
 void BinaryReader::SeekRelative(int64_t offset)
 {
+	if (m_buffered)
+	{
+		Seek(m_offset + offset);
+		return;
+	}
 	BNSeekBinaryReaderRelative(m_stream, offset);
 }
 
 
 bool BinaryReader::IsEndOfFile() const
 {
+	if (m_buffered)
+		return m_offset >= m_view->GetEnd();
 	return BNIsEndOfFile(m_stream);
 }
 
@@ -18,9 +18,14 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <thread>
+#include <exception>
+#include <system_error>
+#include <unordered_set>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
@@ -322,6 +327,16 @@ void BinaryView::FreeCallback(void* ctxt)
 size_t BinaryView::ReadCallback(void* ctxt, void* dest, uint64_t offset, size_t len)
 {
 	BinaryView* view = (BinaryView*)ctxt;
+	shared_ptr<const DirectReadRegion> region = atomic_load(&view->m_directRead);
+	if (region && (offset >= region->start) && ((offset - region->start) < region->length))
+	{
+		uint64_t available = region->length - (offset - region->start);
+		if (len <= available)
+		{
+			memcpy(dest, region->data + (offset - region->start), len);
+			return len;
+		}
+	}
 	return view->PerformRead(dest, offset, len);
 }
 
@@ -329,6 +344,7 @@ size_t BinaryView::ReadCallback(void* ctxt, void* dest, uint64_t offset, size_t
 size_t BinaryView::WriteCallback(void* ctxt, uint64_t offset, const void* src, size_t len)
 {
 	BinaryView* view = (BinaryView*)ctxt;
+	view->DropDirectReadRegion(offset, len);
 	return view->PerformWrite(offset, src, len);
 }
 
@@ -336,6 +352,7 @@ size_t BinaryView::WriteCallback(void* ctxt, uint64_t offset, const void* src, s
 size_t BinaryView::InsertCallback(void* ctxt, uint64_t offset, const void* src, size_t len)
 {
 	BinaryView* view = (BinaryView*)ctxt;
+	view->DropDirectReadRegion(offset, (uint64_t)-1);
 	return view->PerformInsert(offset, src, len);
 }
 
@@ -343,6 +360,7 @@ size_t BinaryView::InsertCallback(void* ctxt, uint64_t offset, const void* src,
 size_t BinaryView::RemoveCallback(void* ctxt, uint64_t offset, uint64_t len)
 {
 	BinaryView* view = (BinaryView*)ctxt;
+	view->DropDirectReadRegion(offset, (uint64_t)-1);
 	return view->PerformRemove(offset, len);
 }
 
@@ -514,6 +532,35 @@ bool BinaryView::PerformSave(FileAccessor* file)
 }
 
 
+void BinaryView::SetDirectReadRegion(uint64_t start, const void* data, uint64_t len)
+{
+	shared_ptr<DirectReadRegion> region;
+	if (data && len)
+	{
+		region = make_shared<DirectReadRegion>();
+		region->data = (const uint8_t*)data;
+		region->start = start;
+		region->length = len;
+	}
+	atomic_store(&m_directRead, shared_ptr<const DirectReadRegion>(region));
+}
+
+
+void BinaryView::DropDirectReadRegion(uint64_t offset, uint64_t len)
+{
+	// Inserts and removals pass a length reaching to the end of the address space, as they move everything
+	// after the offset
+	shared_ptr<const DirectReadRegion> region = atomic_load(&m_directRead);
+	if (!region)
+		return;
+	uint64_t end = offset + len;
+	if (end < offset)
+		end = (uint64_t)-1;
+	if ((offset < region->start + region->length) && (end > region->start))
+		atomic_compare_exchange_strong(&m_directRead, &region, shared_ptr<const DirectReadRegion>());
+}
+
+
 void BinaryView::NotifyDataWritten(uint64_t offset, size_t len)
 {
 	BNNotifyDataWritten(m_object, offset, len);
@@ -648,6 +695,15 @@ DataBuffer BinaryView::ReadBuffer(uint64_t offset, size_t len)
 }
 
 
+DataBufferView BinaryView::ReadBuffer(uint64_t offset, size_t len, DataBuffer& storage)
+{
+	if (storage.GetLength() < len)
+		storage.SetSize(len);
+	size_t read = Read(storage.GetData(), offset, len);
+	return storage.GetView(0, read);
+}
+
+
 size_t BinaryView::WriteBuffer(uint64_t offset, const DataBuffer& data)
 {
 	return BNWriteViewBuffer(m_object, offset, data.GetBufferObject());
@@ -958,6 +1014,12 @@ map<uint64_t, DataVariable> BinaryView::GetDataVariables()
 }
 
 
+DataVariableCursor BinaryView::GetDataVariableCursor(size_t batchSize)
+{
+	return DataVariableCursor(this, batchSize);
+}
+
+
 bool BinaryView::GetDataVariableAtAddress(uint64_t addr, DataVariable& var)
 {
 	var.address = 0;
@@ -981,14 +1043,150 @@ vector<Ref<Function>> BinaryView::GetAnalysisFunctionList()
 	BNFunction** list = BNGetAnalysisFunctionList(m_object, &count);
 
 	vector<Ref<Function>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Function(BNNewFunctionReference(list[i])));
+		result.push_back(Ref<Function>::Adopt(new Function(BNNewFunctionReference(list[i]))));
 
 	BNFreeFunctionList(list, count);
 	return result;
 }
 
 
+FunctionCursor BinaryView::GetAnalysisFunctionCursor(size_t batchSize)
+{
+	return FunctionCursor(this, batchSize);
+}
+
+
+namespace
+{
+	// Range of function indices owned by one worker. The owner takes chunks from the front, thieves take
+	// half of what is left from the back.
+	struct FunctionWorkQueue
+	{
+		mutex lock;
+		size_t begin, end;
+
+		FunctionWorkQueue(): begin(0), end(0) {}
+
+		bool TakeChunk(size_t chunkSize, size_t& chunkBegin, size_t& chunkEnd)
+		{
+			unique_lock<mutex> guard(lock);
+			if (begin >= end)
+				return false;
+			chunkBegin = begin;
+			chunkEnd = min(end, begin + chunkSize);
+			begin = chunkEnd;
+			return true;
+		}
+
+		bool Steal(size_t& stolenBegin, size_t& stolenEnd)
+		{
+			unique_lock<mutex> guard(lock);
+			if (begin >= end)
+				return false;
+			size_t count = (end - begin + 1) / 2;
+			stolenBegin = end - count;
+			stolenEnd = end;
+			end = stolenBegin;
+			return true;
+		}
+
+		void Assign(size_t newBegin, size_t newEnd)
+		{
+			unique_lock<mutex> guard(lock);
+			begin = newBegin;
+			end = newEnd;
+		}
+	};
+}
+
+
+void BinaryView::ParallelForEachFunction(const function<void(Function* func)>& callback, size_t threads,
+	bool advancedAnalysis)
+{
+	vector<Ref<Function>> funcs = GetAnalysisFunctionList();
+	if (funcs.empty())
+		return;
+
+	if (threads == 0)
+		threads = GetWorkerThreadCount();
+	if (threads == 0)
+		threads = thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	threads = min(threads, funcs.size());
+
+	const size_t chunkSize = max<size_t>(1, min<size_t>(64, funcs.size() / (threads * 8)));
+
+	vector<FunctionWorkQueue> queues(threads);
+	for (size_t i = 0; i < threads; i++)
+		queues[i].Assign((funcs.size() * i) / threads, (funcs.size() * (i + 1)) / threads);
+
+	atomic<bool> aborted(false);
+	mutex errorLock;
+	exception_ptr error;
+
+	auto worker = [&](size_t id) {
+		AdvancedFunctionAnalysisDataRequestor requestor;
+		try
+		{
+			while (!aborted)
+			{
+				size_t chunkBegin, chunkEnd;
+				if (!queues[id].TakeChunk(chunkSize, chunkBegin, chunkEnd))
+				{
+					// Out of local work, steal from the other workers starting with the next one over
+					bool stolen = false;
+					for (size_t i = 1; (i < threads) && !stolen; i++)
+						stolen = queues[(id + i) % threads].Steal(chunkBegin, chunkEnd);
+					if (!stolen)
+						break;
+					queues[id].Assign(chunkBegin, chunkEnd);
+					continue;
+				}
+
+				for (size_t i = chunkBegin; (i < chunkEnd) && !aborted; i++)
+				{
+					if (advancedAnalysis)
+						requestor.SetFunction(funcs[i]);
+					callback(funcs[i]);
+				}
+			}
+		}
+		catch (...)
+		{
+			unique_lock<mutex> guard(errorLock);
+			if (!error)
+				error = current_exception();
+			aborted = true;
+		}
+	};
+
+	vector<thread> pool;
+	pool.reserve(threads - 1);
+	for (size_t i = 1; i < threads; i++)
+	{
+		try
+		{
+			pool.push_back(thread(worker, i));
+		}
+		catch (system_error&)
+		{
+			// Out of threads. The queues of workers that never started are stolen by the ones that did, so
+			// carry on with what is running rather than leaving started threads unjoined.
+			break;
+		}
+	}
+	worker(0);
+	for (auto& i : pool)
+		i.join();
+
+	if (error)
+		rethrow_exception(error);
+}
+
+
 bool BinaryView::HasFunctions() const
 {
 	return BNHasFunctions(m_object);
@@ -1019,8 +1217,9 @@ vector<Ref<Function>> BinaryView::GetAnalysisFunctionsForAddress(uint64_t addr)
 	BNFunction** list = BNGetAnalysisFunctionsForAddress(m_object, addr, &count);
 
 	vector<Ref<Function>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Function(BNNewFunctionReference(list[i])));
+		result.push_back(Ref<Function>::Adopt(new Function(BNNewFunctionReference(list[i]))));
 
 	BNFreeFunctionList(list, count);
 	return result;
@@ -1051,8 +1250,9 @@ vector<Ref<BasicBlock>> BinaryView::GetBasicBlocksForAddress(uint64_t addr)
 	BNBasicBlock** blocks = BNGetBasicBlocksForAddress(m_object, addr, &count);
 
 	vector<Ref<BasicBlock>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.push_back(Ref<BasicBlock>::Adopt(new BasicBlock(BNNewBasicBlockReference(blocks[i]))));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -1065,8 +1265,9 @@ vector<Ref<BasicBlock>> BinaryView::GetBasicBlocksStartingAtAddress(uint64_t add
 	BNBasicBlock** blocks = BNGetBasicBlocksStartingAtAddress(m_object, addr, &count);
 
 	vector<Ref<BasicBlock>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.push_back(Ref<BasicBlock>::Adopt(new BasicBlock(BNNewBasicBlockReference(blocks[i]))));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -1137,8 +1338,9 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsByName(const string& name)
 	BNSymbol** syms = BNGetSymbolsByName(m_object, name.c_str(), &count);
 
 	vector<Ref<Symbol>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.push_back(Ref<Symbol>::Adopt(new Symbol(BNNewSymbolReference(syms[i]))));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1151,8 +1353,9 @@ vector<Ref<Symbol>> BinaryView::GetSymbols()
 	BNSymbol** syms = BNGetSymbols(m_object, &count);
 
 	vector<Ref<Symbol>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.push_back(Ref<Symbol>::Adopt(new Symbol(BNNewSymbolReference(syms[i]))));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1165,8 +1368,9 @@ vector<Ref<Symbol>> BinaryView::GetSymbols(uint64_t start, uint64_t len)
 	BNSymbol** syms = BNGetSymbolsInRange(m_object, start, len, &count);
 
 	vector<Ref<Symbol>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.push_back(Ref<Symbol>::Adopt(new Symbol(BNNewSymbolReference(syms[i]))));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1179,8 +1383,9 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsOfType(BNSymbolType type)
 	BNSymbol** syms = BNGetSymbolsOfType(m_object, type, &count);
 
 	vector<Ref<Symbol>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.push_back(Ref<Symbol>::Adopt(new Symbol(BNNewSymbolReference(syms[i]))));
 
 	BNFreeSymbolList(syms, count);
 	return result;
@@ -1193,14 +1398,27 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsOfType(BNSymbolType type, uint64_t sta
 	BNSymbol** syms = BNGetSymbolsOfTypeInRange(m_object, type, start, len, &count);
 
 	vector<Ref<Symbol>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new Symbol(BNNewSymbolReference(syms[i])));
+		result.push_back(Ref<Symbol>::Adopt(new Symbol(BNNewSymbolReference(syms[i]))));
 
 	BNFreeSymbolList(syms, count);
 	return result;
 }
 
 
+SymbolCursor BinaryView::GetSymbolCursor(size_t batchSize)
+{
+	return SymbolCursor(this, batchSize);
+}
+
+
+SymbolCursor BinaryView::GetSymbolCursorOfType(BNSymbolType type, size_t batchSize)
+{
+	return SymbolCursor(this, type, batchSize);
+}
+
+
 void BinaryView::DefineAutoSymbol(Ref<Symbol> sym)
 {
 	BNDefineAutoSymbol(m_object, sym->GetObject());
@@ -1413,19 +1631,8 @@ vector<LinearDisassemblyLine> BinaryView::GetPreviousLinearDisassemblyLines(Line
 		line.block = lines[i].block ? new BasicBlock(BNNewBasicBlockReference(lines[i].block)) : nullptr;
 		line.lineOffset = lines[i].lineOffset;
 		line.contents.addr = lines[i].contents.addr;
-		for (size_t j = 0; j < lines[i].contents.count; j++)
-		{
-			InstructionTextToken token;
-			token.type = lines[i].contents.tokens[j].type;
-			token.text = lines[i].contents.tokens[j].text;
-			token.value = lines[i].contents.tokens[j].value;
-			token.size = lines[i].contents.tokens[j].size;
-			token.operand = lines[i].contents.tokens[j].operand;
-			token.context = lines[i].contents.tokens[j].context;
-			token.confidence = lines[i].contents.tokens[j].confidence;
-			token.address = lines[i].contents.tokens[j].address;
-			line.contents.tokens.push_back(token);
-		}
+		line.contents.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].contents.tokens,
+			lines[i].contents.count);
 		result.push_back(line);
 	}
 
@@ -1459,19 +1666,8 @@ vector<LinearDisassemblyLine> BinaryView::GetNextLinearDisassemblyLines(LinearDi
 		line.block = lines[i].block ? new BasicBlock(BNNewBasicBlockReference(lines[i].block)) : nullptr;
 		line.lineOffset = lines[i].lineOffset;
 		line.contents.addr = lines[i].contents.addr;
-		for (size_t j = 0; j < lines[i].contents.count; j++)
-		{
-			InstructionTextToken token;
-			token.type = lines[i].contents.tokens[j].type;
-			token.text = lines[i].contents.tokens[j].text;
-			token.value = lines[i].contents.tokens[j].value;
-			token.size = lines[i].contents.tokens[j].size;
-			token.operand = lines[i].contents.tokens[j].operand;
-			token.context = lines[i].contents.tokens[j].context;
-			token.confidence = lines[i].contents.tokens[j].confidence;
-			token.address = lines[i].contents.tokens[j].address;
-			line.contents.tokens.push_back(token);
-		}
+		line.contents.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].contents.tokens,
+			lines[i].contents.count);
 		result.push_back(line);
 	}
 
@@ -1939,3 +2135,436 @@ BinaryData::BinaryData(FileMetadata* file, FileAccessor* accessor):
 	BinaryView(BNCreateBinaryDataViewFromFile(file->GetObject(), accessor->GetCallbacks()))
 {
 }
+
+
+FunctionCursor::FunctionCursor(BinaryView* view, size_t batchSize): BatchCursor<Ref<Function>>(batchSize),
+	m_view(view), m_next(view->GetStart()), m_end(view->GetEnd()), m_started(false)
+{
+}
+
+
+bool FunctionCursor::FetchBatch(vector<Ref<Function>>& batch)
+{
+	while (batch.size() < m_batchSize)
+	{
+		uint64_t addr = m_next;
+		if (m_started)
+		{
+			addr = m_view->GetNextFunctionStartAfterAddress(m_next);
+			if ((addr <= m_next) || (addr >= m_end))
+				return !batch.empty();
+		}
+		m_started = true;
+		m_next = addr;
+
+		// Several functions, one per platform, can start at the same address
+		for (auto& func : m_view->GetAnalysisFunctionsForAddress(addr))
+		{
+			if (func->GetStart() == addr)
+				batch.push_back(func);
+		}
+	}
+	return true;
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, size_t batchSize): BatchCursor<Ref<Symbol>>(batchSize),
+	m_view(view), m_filterType(false), m_type(FunctionSymbol), m_next(view->GetStart()), m_end(view->GetEnd()),
+	m_window(0x10000)
+{
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, BNSymbolType type, size_t batchSize):
+	BatchCursor<Ref<Symbol>>(batchSize), m_view(view), m_filterType(true), m_type(type), m_next(view->GetStart()),
+	m_end(view->GetEnd()), m_window(0x10000)
+{
+}
+
+
+bool SymbolCursor::FetchBatch(vector<Ref<Symbol>>& batch)
+{
+	// Query consecutive address windows, growing the window across sparse regions and shrinking it again
+	// when a window returns far more symbols than a batch
+	while (batch.empty() && (m_next < m_end))
+	{
+		uint64_t len = m_window;
+		if (len > (m_end - m_next))
+			len = m_end - m_next;
+
+		size_t count;
+		BNSymbol** syms;
+		if (m_filterType)
+			syms = BNGetSymbolsOfTypeInRange(m_view->GetObject(), m_type, m_next, len, &count);
+		else
+			syms = BNGetSymbolsInRange(m_view->GetObject(), m_next, len, &count);
+
+		batch.reserve(count);
+		for (size_t i = 0; i < count; i++)
+			batch.push_back(Ref<Symbol>::Adopt(new Symbol(BNNewSymbolReference(syms[i]))));
+		BNFreeSymbolList(syms, count);
+
+		m_next += len;
+		if (count == 0)
+		{
+			if (m_window < 0x100000000000000ULL)
+				m_window *= 2;
+		}
+		else if ((count > (m_batchSize * 2)) && (m_window > 1))
+		{
+			m_window /= 2;
+		}
+		else if ((count < (m_batchSize / 2)) && (m_window < 0x100000000000000ULL))
+		{
+			m_window *= 2;
+		}
+	}
+
+	sort(batch.begin(), batch.end(), [](const Ref<Symbol>& a, const Ref<Symbol>& b) {
+		return a->GetAddress() < b->GetAddress();
+	});
+	return m_next < m_end;
+}
+
+
+DataVariableCursor::DataVariableCursor(BinaryView* view, size_t batchSize): BatchCursor<DataVariable>(batchSize),
+	m_view(view), m_next(view->GetStart()), m_end(view->GetEnd()), m_started(false)
+{
+}
+
+
+bool DataVariableCursor::FetchBatch(vector<DataVariable>& batch)
+{
+	while (batch.size() < m_batchSize)
+	{
+		uint64_t addr = m_next;
+		if (m_started)
+		{
+			addr = m_view->GetNextDataVariableAfterAddress(m_next);
+			if ((addr <= m_next) || (addr >= m_end))
+				return !batch.empty();
+		}
+		m_started = true;
+		m_next = addr;
+
+		DataVariable var;
+		if (m_view->GetDataVariableAtAddress(addr, var))
+			batch.push_back(var);
+	}
+	return true;
+}
+
+
+// Reports the code references into [start, end) grouped by target address, in increasing target order, until
+// func returns false. Returns false if the walk was stopped.
+static bool ForEachCodeReferenceTarget(BNBinaryView* view, uint64_t start, uint64_t end,
+	const function<bool(uint64_t, const BNReferenceSource*, size_t)>& func)
+{
+	static const uint64_t leafSize = 16;
+	static const uint64_t fanOut = 16;
+
+	if (start >= end)
+		return true;
+
+	if ((end - start) <= leafSize)
+	{
+		for (uint64_t addr = start; addr < end; addr++)
+		{
+			size_t count;
+			BNReferenceSource* refs = BNGetCodeReferences(view, addr, &count);
+			bool more = (count == 0) || func(addr, refs, count);
+			BNFreeCodeReferences(refs, count);
+			if (!more)
+				return false;
+		}
+		return true;
+	}
+
+	size_t count;
+	BNReferenceSource* refs = BNGetCodeReferencesInRange(view, start, end - start, &count);
+	BNFreeCodeReferences(refs, count);
+	if (count == 0)
+		return true;
+
+	uint64_t step = (end - start + fanOut - 1) / fanOut;
+	if (step < leafSize)
+		step = leafSize;
+	for (uint64_t partStart = start; partStart < end; )
+	{
+		uint64_t partEnd = ((end - partStart) > step) ? (partStart + step) : end;
+		if (!ForEachCodeReferenceTarget(view, partStart, partEnd, func))
+			return false;
+		partStart = partEnd;
+	}
+	return true;
+}
+
+
+CodeReferenceTable::CodeReferenceTable(BinaryView* view)
+{
+	Build(view, view->GetStart(), view->GetEnd());
+}
+
+
+CodeReferenceTable::CodeReferenceTable(BinaryView* view, uint64_t start, uint64_t len)
+{
+	Build(view, start, (len > ((uint64_t)-1 - start)) ? (uint64_t)-1 : (start + len));
+}
+
+
+void CodeReferenceTable::Build(BinaryView* view, uint64_t start, uint64_t end)
+{
+	unordered_map<BNArchitecture*, uint32_t> archIndex;
+	unordered_map<BNFunction*, uint32_t> funcIndex;
+
+	ForEachCodeReferenceTarget(view->GetObject(), start, end,
+		[&](uint64_t to, const BNReferenceSource* refs, size_t count) {
+			for (size_t i = 0; i < count; i++)
+			{
+				auto arch = archIndex.find(refs[i].arch);
+				if (arch == archIndex.end())
+				{
+					arch = archIndex.insert(make_pair(refs[i].arch, (uint32_t)m_archs.size())).first;
+					m_archs.push_back(new CoreArchitecture(refs[i].arch));
+				}
+
+				auto func = funcIndex.find(refs[i].func);
+				if (func == funcIndex.end())
+				{
+					func = funcIndex.insert(make_pair(refs[i].func, (uint32_t)m_functions.size())).first;
+					m_functions.push_back(new Function(BNNewFunctionReference(refs[i].func)));
+				}
+
+				Record record;
+				record.from = refs[i].addr;
+				record.to = to;
+				record.arch = arch->second;
+				record.func = func->second;
+				m_records.push_back(record);
+			}
+			return true;
+		});
+
+	sort(m_records.begin(), m_records.end(), [](const Record& a, const Record& b) {
+		if (a.from != b.from)
+			return a.from < b.from;
+		return a.to < b.to;
+	});
+}
+
+
+CodeReference CodeReferenceTable::GetReference(size_t i) const
+{
+	CodeReference result;
+	result.arch = m_archs[m_records[i].arch];
+	result.from = m_records[i].from;
+	result.func = m_functions[m_records[i].func];
+	result.to = m_records[i].to;
+	return result;
+}
+
+
+CodeReferenceCursor::CodeReferenceCursor(BinaryView* view, size_t batchSize):
+	BatchCursor<CodeReference>(batchSize), m_view(view), m_next(view->GetStart()), m_end(view->GetEnd()),
+	m_window(0x100000)
+{
+}
+
+
+CodeReferenceCursor::CodeReferenceCursor(BinaryView* view, uint64_t start, uint64_t len, size_t batchSize):
+	BatchCursor<CodeReference>(batchSize), m_view(view), m_next(start),
+	m_end((len > ((uint64_t)-1 - start)) ? (uint64_t)-1 : (start + len)), m_window(0x100000)
+{
+}
+
+
+bool CodeReferenceCursor::FetchBatch(vector<CodeReference>& batch)
+{
+	while ((batch.size() < m_batchSize) && (m_next < m_end))
+	{
+		uint64_t windowEnd = ((m_end - m_next) > m_window) ? (m_next + m_window) : m_end;
+		uint64_t next = windowEnd;
+		ForEachCodeReferenceTarget(m_view->GetObject(), m_next, windowEnd,
+			[&](uint64_t to, const BNReferenceSource* refs, size_t count) {
+				size_t first = batch.size();
+				for (size_t i = 0; i < count; i++)
+				{
+					CodeReference ref;
+					ref.arch = new CoreArchitecture(refs[i].arch);
+					ref.from = refs[i].addr;
+					ref.func = new Function(BNNewFunctionReference(refs[i].func));
+					ref.to = to;
+					batch.push_back(ref);
+				}
+				sort(batch.begin() + first, batch.end(),
+					[](const CodeReference& a, const CodeReference& b) { return a.from < b.from; });
+
+				// Once the batch is full, the next one resumes after this target
+				if (batch.size() < m_batchSize)
+					return true;
+				next = to + 1;
+				return false;
+			});
+		m_next = next;
+	}
+	return m_next < m_end;
+}
+
+
+void IncrementalAnalysis::ChangeTracker::OnBinaryDataWritten(BinaryView*, uint64_t offset, size_t len)
+{
+	m_analysis->MarkDirty(offset, len);
+}
+
+
+void IncrementalAnalysis::ChangeTracker::OnBinaryDataInserted(BinaryView*, uint64_t offset, size_t len)
+{
+	// Blocks covering the insertion point are split by the new bytes
+	m_analysis->MarkDirty(offset, (len == 0) ? 1 : len);
+}
+
+
+void IncrementalAnalysis::ChangeTracker::OnBinaryDataRemoved(BinaryView*, uint64_t offset, uint64_t len)
+{
+	m_analysis->MarkDirty(offset, (len == 0) ? 1 : len);
+}
+
+
+IncrementalAnalysis::IncrementalAnalysis(BinaryView* view): m_view(view), m_index(view)
+{
+	m_tracker.reset(new ChangeTracker(this));
+	m_view->RegisterNotification(m_tracker.get());
+}
+
+
+IncrementalAnalysis::~IncrementalAnalysis()
+{
+	m_view->UnregisterNotification(m_tracker.get());
+}
+
+
+void IncrementalAnalysis::MarkDirty(uint64_t offset, uint64_t len)
+{
+	if (len == 0)
+		return;
+	uint64_t end = (len > ((uint64_t)-1 - offset)) ? (uint64_t)-1 : (offset + len);
+
+	unique_lock<mutex> lock(m_mutex);
+	m_dirty.push_back(pair<uint64_t, uint64_t>(offset, end));
+}
+
+
+bool IncrementalAnalysis::HasPendingChanges()
+{
+	unique_lock<mutex> lock(m_mutex);
+	return !m_dirty.empty();
+}
+
+
+vector<pair<uint64_t, uint64_t>> IncrementalAnalysis::TakeDirtyRanges()
+{
+	vector<pair<uint64_t, uint64_t>> ranges;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		ranges.swap(m_dirty);
+	}
+
+	// Coalesce overlapping and adjacent ranges, as patch loops tend to write the same bytes repeatedly
+	sort(ranges.begin(), ranges.end());
+	vector<pair<uint64_t, uint64_t>> result;
+	for (auto& i : ranges)
+	{
+		if ((!result.empty()) && (i.first <= result.back().second))
+		{
+			if (i.second > result.back().second)
+				result.back().second = i.second;
+			continue;
+		}
+		result.push_back(i);
+	}
+	return result;
+}
+
+
+vector<Ref<Function>> IncrementalAnalysis::GetFunctionsForRanges(const vector<pair<uint64_t, uint64_t>>& ranges)
+{
+	vector<Ref<Function>> result;
+	if (ranges.empty())
+		return result;
+
+	// Patches usually touch a few bytes, which are cheaper to look up through the blocks containing them than
+	// to index the whole view for. Larger changes fall back to the block index.
+	static const uint64_t maxAddressQueries = 256;
+	uint64_t total = 0;
+	for (auto& i : ranges)
+	{
+		total += i.second - i.first;
+		if (total > maxAddressQueries)
+			break;
+	}
+
+	if (total <= maxAddressQueries)
+	{
+		unordered_set<BNFunction*> found;
+		for (auto& i : ranges)
+		{
+			for (uint64_t addr = i.first; addr < i.second; )
+			{
+				// Continue after the first of the blocks at this address to end, or at the next byte if there
+				// are none
+				uint64_t next = addr + 1;
+				bool first = true;
+				for (auto& block : m_view->GetBasicBlocksForAddress(addr))
+				{
+					uint64_t end = block->GetEnd();
+					if ((end > addr) && (first || (end < next)))
+					{
+						next = end;
+						first = false;
+					}
+
+					Ref<Function> func = block->GetFunction();
+					if (func && found.insert(func->GetObject()).second)
+						result.push_back(func);
+				}
+				addr = next;
+			}
+		}
+		return result;
+	}
+
+	shared_ptr<const BasicBlockIndex> index = m_index.GetIndex();
+	vector<bool> found(index->GetFunctionCount(), false);
+	for (auto& i : ranges)
+	{
+		index->ForEachOverlapping(i.first, i.second, [&](const BasicBlockIndex::Range& range) {
+			if (found[range.function])
+				return;
+			found[range.function] = true;
+			result.push_back(index->GetFunction(range.function));
+		});
+	}
+	return result;
+}
+
+
+vector<Ref<Function>> IncrementalAnalysis::GetDirtyFunctions()
+{
+	vector<pair<uint64_t, uint64_t>> ranges;
+	{
+		unique_lock<mutex> lock(m_mutex);
+		ranges = m_dirty;
+	}
+	return GetFunctionsForRanges(ranges);
+}
+
+
+size_t IncrementalAnalysis::Reanalyze(bool updateAnalysis)
+{
+	vector<Ref<Function>> funcs = GetFunctionsForRanges(TakeDirtyRanges());
+	for (auto& i : funcs)
+		i->Reanalyze();
+	if (updateAnalysis && (!funcs.empty()))
+		m_view->UpdateAnalysis();
+	return funcs.size();
+}
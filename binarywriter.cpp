@@ -18,13 +18,57 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data)
+static inline void EncodeLE16(uint8_t* data, uint16_t val)
+{
+	data[0] = (uint8_t)val;
+	data[1] = (uint8_t)(val >> 8);
+}
+
+
+static inline void EncodeLE32(uint8_t* data, uint32_t val)
+{
+	EncodeLE16(data, (uint16_t)val);
+	EncodeLE16(data + 2, (uint16_t)(val >> 16));
+}
+
+
+static inline void EncodeLE64(uint8_t* data, uint64_t val)
+{
+	EncodeLE32(data, (uint32_t)val);
+	EncodeLE32(data + 4, (uint32_t)(val >> 32));
+}
+
+
+static inline void EncodeBE16(uint8_t* data, uint16_t val)
+{
+	data[0] = (uint8_t)(val >> 8);
+	data[1] = (uint8_t)val;
+}
+
+
+static inline void EncodeBE32(uint8_t* data, uint32_t val)
+{
+	EncodeBE16(data, (uint16_t)(val >> 16));
+	EncodeBE16(data + 2, (uint16_t)val);
+}
+
+
+static inline void EncodeBE64(uint8_t* data, uint64_t val)
+{
+	EncodeBE32(data, (uint32_t)(val >> 32));
+	EncodeBE32(data + 4, (uint32_t)val);
+}
+
+
+BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data), m_endian(endian),
+	m_transaction(false), m_offset(0)
 {
 	m_stream = BNCreateBinaryWriter(data->GetObject());
 	BNSetBinaryWriterEndianness(m_stream, endian);
@@ -39,19 +83,121 @@ BinaryWriter::~BinaryWriter()
 
 BNEndianness BinaryWriter::GetEndianness() const
 {
-	return BNGetBinaryWriterEndianness(m_stream);
+	return m_endian;
 }
 
 
 void BinaryWriter::SetEndianness(BNEndianness endian)
 {
+	m_endian = endian;
 	BNSetBinaryWriterEndianness(m_stream, endian);
 }
 
 
+void BinaryWriter::BeginTransaction()
+{
+	if (m_transaction)
+		return;
+	m_offset = BNGetWriterPosition(m_stream);
+	m_transaction = true;
+}
+
+
+bool BinaryWriter::CommitTransaction()
+{
+	if (!m_transaction)
+		return true;
+
+	bool ok = true;
+	if (!m_pending.empty())
+	{
+		m_view->BeginUndoActions();
+		for (auto& i : m_pending)
+		{
+			if (m_view->Write(i.first, &i.second[0], i.second.size()) != i.second.size())
+				ok = false;
+		}
+		m_view->CommitUndoActions();
+	}
+
+	BNSeekBinaryWriter(m_stream, m_offset);
+	m_pending.clear();
+	m_transaction = false;
+	return ok;
+}
+
+
+void BinaryWriter::AbortTransaction()
+{
+	if (!m_transaction)
+		return;
+	BNSeekBinaryWriter(m_stream, m_offset);
+	m_pending.clear();
+	m_transaction = false;
+}
+
+
+void BinaryWriter::StageWrite(const void* src, size_t len)
+{
+	if (len == 0)
+		return;
+
+	uint64_t start = m_offset;
+	uint64_t end = m_offset + len;
+	m_offset = end;
+
+	// Find the first staged run that overlaps or touches the new range
+	auto i = m_pending.upper_bound(start);
+	if (i != m_pending.begin())
+	{
+		auto prev = i;
+		--prev;
+		if ((prev->first + prev->second.size()) >= start)
+			i = prev;
+	}
+
+	if ((i == m_pending.end()) || (i->first > end))
+	{
+		m_pending[start] = vector<uint8_t>((const uint8_t*)src, (const uint8_t*)src + len);
+		return;
+	}
+
+	// Grow the first touching run to cover everything, folding in any later runs that now overlap it
+	if (i->first > start)
+	{
+		vector<uint8_t> data(i->second.size() + (size_t)(i->first - start));
+		memcpy(&data[(size_t)(i->first - start)], &i->second[0], i->second.size());
+		i = m_pending.erase(i);
+		i = m_pending.insert(i, make_pair(start, move(data)));
+	}
+
+	vector<uint8_t>& run = i->second;
+	uint64_t runStart = i->first;
+	auto next = i;
+	++next;
+	while ((next != m_pending.end()) && (next->first <= end))
+	{
+		uint64_t nextEnd = next->first + next->second.size();
+		if (nextEnd > end)
+		{
+			size_t oldSize = run.size();
+			if ((runStart + oldSize) < nextEnd)
+				run.resize((size_t)(nextEnd - runStart));
+			memcpy(&run[(size_t)(end - runStart)], &next->second[(size_t)(end - next->first)],
+				(size_t)(nextEnd - end));
+		}
+		next = m_pending.erase(next);
+	}
+
+	if ((runStart + run.size()) < end)
+		run.resize((size_t)(end - runStart));
+	memcpy(&run[(size_t)(start - runStart)], src, len);
+}
+
+
 void BinaryWriter::Write(const void* src, size_t len)
 {
-	if (!BNWriteData(m_stream, src, len))
+	if (!TryWrite(src, len))
 		throw WriteException();
 }
 
@@ -70,76 +216,81 @@ void BinaryWriter::Write(const string& str)
 
 void BinaryWriter::Write8(uint8_t val)
 {
-	if (!BNWrite8(m_stream, val))
+	if (!TryWrite8(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::Write16(uint16_t val)
 {
-	if (!BNWrite16(m_stream, val))
+	if (!TryWrite16(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::Write32(uint32_t val)
 {
-	if (!BNWrite32(m_stream, val))
+	if (!TryWrite32(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::Write64(uint64_t val)
 {
-	if (!BNWrite64(m_stream, val))
+	if (!TryWrite64(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::WriteLE16(uint16_t val)
 {
-	if (!BNWriteLE16(m_stream, val))
+	if (!TryWriteLE16(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::WriteLE32(uint32_t val)
 {
-	if (!BNWriteLE32(m_stream, val))
+	if (!TryWriteLE32(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::WriteLE64(uint64_t val)
 {
-	if (!BNWriteLE64(m_stream, val))
+	if (!TryWriteLE64(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::WriteBE16(uint16_t val)
 {
-	if (!BNWriteBE16(m_stream, val))
+	if (!TryWriteBE16(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::WriteBE32(uint32_t val)
 {
-	if (!BNWriteBE32(m_stream, val))
+	if (!TryWriteBE32(val))
 		throw WriteException();
 }
 
 
 void BinaryWriter::WriteBE64(uint64_t val)
 {
-	if (!BNWriteBE64(m_stream, val))
+	if (!TryWriteBE64(val))
 		throw WriteException();
 }
 
 
 bool BinaryWriter::TryWrite(const void* src, size_t len)
 {
+	if (m_transaction)
+	{
+		StageWrite(src, len);
+		return true;
+	}
 	return BNWriteData(m_stream, src, len);
 }
 
@@ -158,77 +309,142 @@ bool BinaryWriter::TryWrite(const string& str)
 
 bool BinaryWriter::TryWrite8(uint8_t val)
 {
+	if (m_transaction)
+	{
+		StageWrite(&val, 1);
+		return true;
+	}
 	return BNWrite8(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWrite16(uint16_t val)
 {
+	if (m_transaction)
+		return (m_endian == LittleEndian) ? TryWriteLE16(val) : TryWriteBE16(val);
 	return BNWrite16(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWrite32(uint32_t val)
 {
+	if (m_transaction)
+		return (m_endian == LittleEndian) ? TryWriteLE32(val) : TryWriteBE32(val);
 	return BNWrite32(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWrite64(uint64_t val)
 {
+	if (m_transaction)
+		return (m_endian == LittleEndian) ? TryWriteLE64(val) : TryWriteBE64(val);
 	return BNWrite64(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWriteLE16(uint16_t val)
 {
+	if (m_transaction)
+	{
+		uint8_t data[2];
+		EncodeLE16(data, val);
+		StageWrite(data, sizeof(data));
+		return true;
+	}
 	return BNWriteLE16(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWriteLE32(uint32_t val)
 {
+	if (m_transaction)
+	{
+		uint8_t data[4];
+		EncodeLE32(data, val);
+		StageWrite(data, sizeof(data));
+		return true;
+	}
 	return BNWriteLE32(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWriteLE64(uint64_t val)
 {
+	if (m_transaction)
+	{
+		uint8_t data[8];
+		EncodeLE64(data, val);
+		StageWrite(data, sizeof(data));
+		return true;
+	}
 	return BNWriteLE64(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWriteBE16(uint16_t val)
 {
+	if (m_transaction)
+	{
+		uint8_t data[2];
+		EncodeBE16(data, val);
+		StageWrite(data, sizeof(data));
+		return true;
+	}
 	return BNWriteBE16(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWriteBE32(uint32_t val)
 {
+	if (m_transaction)
+	{
+		uint8_t data[4];
+		EncodeBE32(data, val);
+		StageWrite(data, sizeof(data));
+		return true;
+	}
 	return BNWriteBE32(m_stream, val);
 }
 
 
 bool BinaryWriter::TryWriteBE64(uint64_t val)
 {
+	if (m_transaction)
+	{
+		uint8_t data[8];
+		EncodeBE64(data, val);
+		StageWrite(data, sizeof(data));
+		return true;
+	}
 	return BNWriteBE64(m_stream, val);
 }
 
 
 uint64_t BinaryWriter::GetOffset() const
 {
+	if (m_transaction)
+		return m_offset;
 	return BNGetWriterPosition(m_stream);
 }
 
 
 void BinaryWriter::Seek(uint64_t offset)
 {
+	if (m_transaction)
+	{
+		m_offset = offset;
+		return;
+	}
 	BNSeekBinaryWriter(m_stream, offset);
 }
 
 
 void BinaryWriter::SeekRelative(int64_t offset)
 {
+	if (m_transaction)
+	{
+		m_offset += offset;
+		return;
+	}
 	BNSeekBinaryWriterRelative(m_stream, offset);
 }
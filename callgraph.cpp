@@ -0,0 +1,383 @@
+// Copyright (c) 2015-2017 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+CallGraph::CallGraph(BinaryView* view)
+{
+	vector<Ref<Function>> funcs = view->GetAnalysisFunctionList();
+	vector<FunctionCalls> calls;
+	calls.reserve(funcs.size());
+	for (auto& i : funcs)
+	{
+		FunctionCalls entry;
+		entry.func = i;
+		entry.targets = GetCallTargets(i);
+		calls.push_back(move(entry));
+	}
+
+	vector<const FunctionCalls*> functions;
+	functions.reserve(calls.size());
+	for (auto& i : calls)
+		functions.push_back(&i);
+	Build(move(functions));
+}
+
+
+CallGraph::CallGraph(const vector<const FunctionCalls*>& functions)
+{
+	Build(functions);
+}
+
+
+void CallGraph::Build(vector<const FunctionCalls*> functions)
+{
+	vector<pair<uint64_t, const FunctionCalls*>> sorted;
+	sorted.reserve(functions.size());
+	for (auto i : functions)
+		sorted.push_back(make_pair(i->func->GetStart(), i));
+	stable_sort(sorted.begin(), sorted.end(),
+		[](const pair<uint64_t, const FunctionCalls*>& a, const pair<uint64_t, const FunctionCalls*>& b) {
+			return a.first < b.first;
+		});
+
+	size_t count = sorted.size();
+	m_functions.reserve(count);
+	m_starts.reserve(count);
+	m_nodes.reserve(count);
+	for (auto& i : sorted)
+	{
+		m_nodes[i.second->func->GetObject()] = (uint32_t)m_functions.size();
+		m_functions.push_back(i.second->func);
+		m_starts.push_back(i.first);
+	}
+
+	// Resolve call targets to the nodes starting at each target address
+	m_calleeOffsets.reserve(count + 1);
+	for (auto& i : sorted)
+	{
+		size_t first = m_callees.size();
+		m_calleeOffsets.push_back((uint32_t)first);
+		for (auto target : i.second->targets)
+		{
+			auto node = lower_bound(m_starts.begin(), m_starts.end(), target);
+			for (; (node != m_starts.end()) && (*node == target); ++node)
+				m_callees.push_back((uint32_t)(node - m_starts.begin()));
+		}
+		sort(m_callees.begin() + first, m_callees.end());
+		m_callees.erase(unique(m_callees.begin() + first, m_callees.end()), m_callees.end());
+	}
+	m_calleeOffsets.push_back((uint32_t)m_callees.size());
+
+	// Transpose into the caller arrays; filling in order of caller keeps each caller list sorted
+	m_callerOffsets.assign(count + 1, 0);
+	for (auto callee : m_callees)
+		m_callerOffsets[callee + 1]++;
+	for (size_t i = 0; i < count; i++)
+		m_callerOffsets[i + 1] += m_callerOffsets[i];
+	m_callers.resize(m_callees.size());
+	vector<uint32_t> next(m_callerOffsets.begin(), m_callerOffsets.end() - 1);
+	for (size_t caller = 0; caller < count; caller++)
+	{
+		for (uint32_t i = m_calleeOffsets[caller]; i < m_calleeOffsets[caller + 1]; i++)
+			m_callers[next[m_callees[i]]++] = (uint32_t)caller;
+	}
+}
+
+
+vector<uint64_t> CallGraph::GetCallTargets(Function* func)
+{
+	vector<uint64_t> result;
+	Ref<LowLevelILFunction> il = func->GetLowLevelIL();
+	if (!il || !il->GetObject())
+		return result;
+
+	size_t count = il->GetInstructionCount();
+	for (size_t i = 0; i < count; i++)
+	{
+		BNLowLevelILInstruction instr = il->GetRawExpr(il->GetIndexForInstruction(i));
+		switch (instr.operation)
+		{
+		case LLIL_CALL:
+		case LLIL_CALL_STACK_ADJUST:
+		case LLIL_JUMP:
+			break;
+		default:
+			continue;
+		}
+
+		BNLowLevelILInstruction dest = il->GetRawExpr((size_t)instr.operands[0]);
+		if ((dest.operation == LLIL_CONST_PTR) || (dest.operation == LLIL_CONST))
+			result.push_back(dest.operands[0]);
+	}
+
+	sort(result.begin(), result.end());
+	result.erase(unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+
+bool CallGraph::GetNode(Function* func, size_t& node) const
+{
+	auto i = m_nodes.find(func->GetObject());
+	if (i == m_nodes.end())
+		return false;
+	node = i->second;
+	return true;
+}
+
+
+const uint32_t* CallGraph::GetCallees(size_t node, size_t& count) const
+{
+	count = m_calleeOffsets[node + 1] - m_calleeOffsets[node];
+	return m_callees.data() + m_calleeOffsets[node];
+}
+
+
+const uint32_t* CallGraph::GetCallers(size_t node, size_t& count) const
+{
+	count = m_callerOffsets[node + 1] - m_callerOffsets[node];
+	return m_callers.data() + m_callerOffsets[node];
+}
+
+
+vector<Ref<Function>> CallGraph::GetCallees(Function* func) const
+{
+	vector<Ref<Function>> result;
+	size_t node, count;
+	if (!GetNode(func, node))
+		return result;
+	const uint32_t* callees = GetCallees(node, count);
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		result.push_back(m_functions[callees[i]]);
+	return result;
+}
+
+
+vector<Ref<Function>> CallGraph::GetCallers(Function* func) const
+{
+	vector<Ref<Function>> result;
+	size_t node, count;
+	if (!GetNode(func, node))
+		return result;
+	const uint32_t* callers = GetCallers(node, count);
+	result.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		result.push_back(m_functions[callers[i]]);
+	return result;
+}
+
+
+size_t CallGraph::GetStronglyConnectedComponents(vector<uint32_t>& components) const
+{
+	// Iterative Tarjan. A component is completed only after every component reachable from it, so numbering
+	// components in completion order gives callees lower indices than their callers.
+	const uint32_t none = 0xffffffff;
+	size_t count = m_functions.size();
+	vector<uint32_t> order(count, none);
+	vector<uint32_t> low(count);
+	vector<uint32_t> stack;
+	vector<pair<uint32_t, uint32_t>> work;
+	components.assign(count, none);
+	uint32_t nextOrder = 0;
+	uint32_t nextComponent = 0;
+
+	for (uint32_t root = 0; root < count; root++)
+	{
+		if (order[root] != none)
+			continue;
+
+		order[root] = low[root] = nextOrder++;
+		stack.push_back(root);
+		work.push_back(make_pair(root, m_calleeOffsets[root]));
+		while (!work.empty())
+		{
+			uint32_t node = work.back().first;
+			uint32_t edge = work.back().second;
+			if (edge < m_calleeOffsets[node + 1])
+			{
+				work.back().second++;
+				uint32_t callee = m_callees[edge];
+				if (order[callee] == none)
+				{
+					order[callee] = low[callee] = nextOrder++;
+					stack.push_back(callee);
+					work.push_back(make_pair(callee, m_calleeOffsets[callee]));
+				}
+				else if (components[callee] == none)
+				{
+					// Visited without a component means the callee is still on the stack
+					low[node] = min(low[node], order[callee]);
+				}
+				continue;
+			}
+
+			work.pop_back();
+			if (!work.empty())
+				low[work.back().first] = min(low[work.back().first], low[node]);
+
+			if (low[node] == order[node])
+			{
+				uint32_t member;
+				do
+				{
+					member = stack.back();
+					stack.pop_back();
+					components[member] = nextComponent;
+				} while (member != node);
+				nextComponent++;
+			}
+		}
+	}
+	return nextComponent;
+}
+
+
+vector<uint32_t> CallGraph::GetBottomUpOrder() const
+{
+	vector<uint32_t> components;
+	size_t componentCount = GetStronglyConnectedComponents(components);
+
+	vector<uint32_t> offsets(componentCount + 1, 0);
+	for (auto i : components)
+		offsets[i + 1]++;
+	for (size_t i = 0; i < componentCount; i++)
+		offsets[i + 1] += offsets[i];
+
+	vector<uint32_t> result(components.size());
+	for (uint32_t node = 0; node < components.size(); node++)
+		result[offsets[components[node]]++] = node;
+	return result;
+}
+
+
+vector<uint32_t> CallGraph::GetTopDownOrder() const
+{
+	vector<uint32_t> result = GetBottomUpOrder();
+	reverse(result.begin(), result.end());
+	return result;
+}
+
+
+void CallGraphCache::UpdateTracker::OnAnalysisFunctionAdded(BinaryView*, Function* func)
+{
+	m_cache->QueueUpdate(func);
+}
+
+
+void CallGraphCache::UpdateTracker::OnAnalysisFunctionRemoved(BinaryView*, Function* func)
+{
+	m_cache->QueueRemoval(func);
+}
+
+
+void CallGraphCache::UpdateTracker::OnAnalysisFunctionUpdated(BinaryView*, Function* func)
+{
+	m_cache->QueueUpdate(func);
+}
+
+
+CallGraphCache::CallGraphCache(BinaryView* view): m_view(view), m_populated(false)
+{
+	m_tracker.reset(new UpdateTracker(this));
+	m_view->RegisterNotification(m_tracker.get());
+}
+
+
+CallGraphCache::~CallGraphCache()
+{
+	m_view->UnregisterNotification(m_tracker.get());
+}
+
+
+void CallGraphCache::QueueUpdate(Function* func)
+{
+	unique_lock<mutex> lock(m_pendingMutex);
+	m_pendingRemovals.erase(func->GetObject());
+	m_pendingUpdates[func->GetObject()] = func;
+}
+
+
+void CallGraphCache::QueueRemoval(Function* func)
+{
+	unique_lock<mutex> lock(m_pendingMutex);
+	m_pendingUpdates.erase(func->GetObject());
+	m_pendingRemovals[func->GetObject()] = func;
+}
+
+
+shared_ptr<const CallGraph> CallGraphCache::GetGraph()
+{
+	unique_lock<mutex> lock(m_mutex);
+
+	unordered_map<BNFunction*, Ref<Function>> updates, removals;
+	{
+		unique_lock<mutex> pendingLock(m_pendingMutex);
+		updates.swap(m_pendingUpdates);
+		removals.swap(m_pendingRemovals);
+	}
+
+	if (!m_populated.exchange(true))
+	{
+		// A full scan already reflects every change queued before it started
+		m_calls.clear();
+		for (auto& i : m_view->GetAnalysisFunctionList())
+		{
+			CallGraph::FunctionCalls& entry = m_calls[i->GetObject()];
+			entry.func = i;
+			entry.targets = CallGraph::GetCallTargets(i);
+		}
+	}
+	else if (updates.empty() && removals.empty() && m_graph)
+	{
+		return m_graph;
+	}
+	else
+	{
+		for (auto& i : removals)
+			m_calls.erase(i.first);
+		for (auto& i : updates)
+		{
+			CallGraph::FunctionCalls& entry = m_calls[i.first];
+			entry.func = i.second;
+			entry.targets = CallGraph::GetCallTargets(i.second);
+		}
+	}
+
+	vector<const CallGraph::FunctionCalls*> functions;
+	functions.reserve(m_calls.size());
+	for (auto& i : m_calls)
+		functions.push_back(&i.second);
+	m_graph = make_shared<CallGraph>(functions);
+	return m_graph;
+}
+
+
+void CallGraphCache::Invalidate()
+{
+	m_populated = false;
+}
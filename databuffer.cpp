@@ -48,6 +48,20 @@ DataBuffer::DataBuffer(const DataBuffer& buf)
 }
 
 
+DataBuffer::DataBuffer(DataBuffer&& buf) NOEXCEPT
+{
+	// Leave the source as a valid empty buffer, so that it can still be used
+	m_buffer = buf.m_buffer;
+	buf.m_buffer = BNCreateDataBuffer(nullptr, 0);
+}
+
+
+DataBuffer::DataBuffer(const DataBufferView& view)
+{
+	m_buffer = BNCreateDataBuffer(view.GetData(), view.GetLength());
+}
+
+
 DataBuffer::DataBuffer(BNDataBuffer* buf)
 {
 	m_buffer = buf;
@@ -56,18 +70,43 @@ DataBuffer::DataBuffer(BNDataBuffer* buf)
 
 DataBuffer::~DataBuffer()
 {
-	BNFreeDataBuffer(m_buffer);
+	if (m_buffer)
+		BNFreeDataBuffer(m_buffer);
 }
 
 
 DataBuffer& DataBuffer::operator=(const DataBuffer& buf)
 {
-	BNFreeDataBuffer(m_buffer);
-	m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+	if (this == &buf)
+		return *this;
+	BNDataBuffer* newBuffer = BNDuplicateDataBuffer(buf.m_buffer);
+	if (m_buffer)
+		BNFreeDataBuffer(m_buffer);
+	m_buffer = newBuffer;
+	return *this;
+}
+
+
+DataBuffer& DataBuffer::operator=(DataBuffer&& buf) NOEXCEPT
+{
+	if (this == &buf)
+		return *this;
+	if (m_buffer)
+		BNFreeDataBuffer(m_buffer);
+	m_buffer = buf.m_buffer;
+	buf.m_buffer = BNCreateDataBuffer(nullptr, 0);
 	return *this;
 }
 
 
+BNDataBuffer* DataBuffer::DetachBufferObject()
+{
+	BNDataBuffer* result = m_buffer;
+	m_buffer = nullptr;
+	return result;
+}
+
+
 void* DataBuffer::GetData()
 {
 	return BNGetDataBufferContents(m_buffer);
@@ -135,6 +174,18 @@ DataBuffer DataBuffer::GetSlice(size_t start, size_t len)
 }
 
 
+DataBufferView DataBuffer::GetView() const
+{
+	return DataBufferView(*this);
+}
+
+
+DataBufferView DataBuffer::GetView(size_t start, size_t len) const
+{
+	return DataBufferView(*this).GetSlice(start, len);
+}
+
+
 uint8_t& DataBuffer::operator[](size_t offset)
 {
 	return ((uint8_t*)GetData())[offset];
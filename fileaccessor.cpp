@@ -18,6 +18,13 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
@@ -34,6 +41,12 @@ uint64_t FileAccessor::GetLengthCallback(void* ctxt)
 size_t FileAccessor::ReadCallback(void* ctxt, void* dest, uint64_t offset, size_t len)
 {
 	FileAccessor* file = (FileAccessor*)ctxt;
+	const void* src = file->GetPointer(offset, len);
+	if (src)
+	{
+		memcpy(dest, src, len);
+		return len;
+	}
 	return file->Read(dest, offset, len);
 }
 
@@ -81,3 +94,111 @@ size_t CoreFileAccessor::Write(uint64_t offset, const void* src, size_t len)
 	return m_callbacks.write(m_callbacks.context, offset, src, len);
 }
 
+
+
+MappedFileAccessor::MappedFileAccessor(const string& path, bool writable): m_data(nullptr), m_length(0),
+	m_writable(writable), m_valid(false)
+{
+#ifdef WIN32
+	m_mapping = NULL;
+	m_file = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size))
+		return;
+	if (size.QuadPart == 0)
+	{
+		// Empty files cannot be mapped, but there is nothing to read from them either
+		m_valid = true;
+		return;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, NULL);
+	if (!m_mapping)
+		return;
+
+	m_data = (uint8_t*)MapViewOfFile(m_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+	if (m_data)
+	{
+		m_length = (uint64_t)size.QuadPart;
+		m_valid = true;
+	}
+#else
+	int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+	{
+		close(fd);
+		return;
+	}
+	if (st.st_size == 0)
+	{
+		// Empty files cannot be mapped, but there is nothing to read from them either
+		m_valid = true;
+		close(fd);
+		return;
+	}
+
+	// The mapping keeps its own reference to the file, so the descriptor is not needed afterwards
+	void* data = mmap(nullptr, (size_t)st.st_size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return;
+
+	m_data = (uint8_t*)data;
+	m_length = (uint64_t)st.st_size;
+	m_valid = true;
+#endif
+}
+
+
+MappedFileAccessor::~MappedFileAccessor()
+{
+#ifdef WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+#else
+	if (m_data)
+		munmap(m_data, (size_t)m_length);
+#endif
+}
+
+
+size_t MappedFileAccessor::Read(void* dest, uint64_t offset, size_t len)
+{
+	if (offset >= m_length)
+		return 0;
+	if (len > (m_length - offset))
+		len = (size_t)(m_length - offset);
+	memcpy(dest, m_data + offset, len);
+	return len;
+}
+
+
+size_t MappedFileAccessor::Write(uint64_t offset, const void* src, size_t len)
+{
+	if ((!m_writable) || (offset >= m_length))
+		return 0;
+	if (len > (m_length - offset))
+		len = (size_t)(m_length - offset);
+	memcpy(m_data + offset, src, len);
+	return len;
+}
+
+
+const void* MappedFileAccessor::GetPointer(uint64_t offset, size_t len)
+{
+	if ((!m_data) || (offset > m_length) || (len > (m_length - offset)))
+		return nullptr;
+	return m_data + offset;
+}
@@ -119,6 +119,12 @@ Function::~Function()
 }
 
 
+Ref<BinaryView> Function::GetView() const
+{
+	return new BinaryView(BNGetFunctionData(m_object));
+}
+
+
 Ref<Platform> Function::GetPlatform() const
 {
 	return new Platform(BNGetFunctionPlatform(m_object));
@@ -174,8 +180,9 @@ vector<Ref<BasicBlock>> Function::GetBasicBlocks() const
 	BNBasicBlock** blocks = BNGetFunctionBasicBlockList(m_object, &count);
 
 	vector<Ref<BasicBlock>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.push_back(Ref<BasicBlock>::Adopt(new BasicBlock(BNNewBasicBlockReference(blocks[i]))));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -191,6 +198,12 @@ Ref<BasicBlock> Function::GetBasicBlockAtAddress(Architecture* arch, uint64_t ad
 }
 
 
+CFGSnapshot Function::GetCFGSnapshot()
+{
+	return CFGSnapshot(this);
+}
+
+
 void Function::MarkRecentUse()
 {
 	BNMarkFunctionAsRecentlyUsed(m_object);
@@ -942,24 +955,9 @@ vector<vector<InstructionTextToken>> Function::GetBlockAnnotations(Architecture*
 	BNInstructionTextLine* lines = BNGetFunctionBlockAnnotations(m_object, arch->GetObject(), addr, &count);
 
 	vector<vector<InstructionTextToken>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-	{
-		vector<InstructionTextToken> line;
-		for (size_t j = 0; j < lines[i].count; j++)
-		{
-			InstructionTextToken token;
-			token.type = lines[i].tokens[j].type;
-			token.text = lines[i].tokens[j].text;
-			token.value = lines[i].tokens[j].value;
-			token.size = lines[i].tokens[j].size;
-			token.operand = lines[i].tokens[j].operand;
-			token.context = lines[i].tokens[j].context;
-			token.confidence = lines[i].tokens[j].confidence;
-			token.address = lines[i].tokens[j].address;
-			line.push_back(token);
-		}
-		result.push_back(line);
-	}
+		result.push_back(InstructionTextToken::ConvertInstructionTextTokenList(lines[i].tokens, lines[i].count));
 
 	BNFreeInstructionTextLines(lines, count);
 	return result;
@@ -1114,6 +1112,13 @@ void Function::Reanalyze()
 }
 
 
+shared_ptr<const LoopInfo> Function::GetLoopInfo()
+{
+	Ref<BinaryView> view = GetView();
+	return LoopInfoCache::GetForView(view)->GetLoopInfo(this);
+}
+
+
 void Function::RequestAdvancedAnalysisData()
 {
 	BNRequestAdvancedFunctionAnalysisData(m_object);
@@ -1160,19 +1165,7 @@ vector<DisassemblyTextLine> Function::GetTypeTokens(DisassemblySettings* setting
 	{
 		DisassemblyTextLine line;
 		line.addr = lines[i].addr;
-		for (size_t j = 0; j < lines[i].count; j++)
-		{
-			InstructionTextToken token;
-			token.type = lines[i].tokens[j].type;
-			token.text = lines[i].tokens[j].text;
-			token.value = lines[i].tokens[j].value;
-			token.size = lines[i].tokens[j].size;
-			token.operand = lines[i].tokens[j].operand;
-			token.context = lines[i].tokens[j].context;
-			token.confidence = lines[i].tokens[j].confidence;
-			token.address = lines[i].tokens[j].address;
-			line.tokens.push_back(token);
-		}
+		line.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].tokens, lines[i].count);
 		result.push_back(line);
 	}
 
@@ -1196,6 +1189,13 @@ AdvancedFunctionAnalysisDataRequestor::AdvancedFunctionAnalysisDataRequestor(con
 }
 
 
+AdvancedFunctionAnalysisDataRequestor::AdvancedFunctionAnalysisDataRequestor(AdvancedFunctionAnalysisDataRequestor&& req):
+	m_func(std::move(req.m_func))
+{
+	// The outstanding request moves along with the function reference
+}
+
+
 AdvancedFunctionAnalysisDataRequestor::~AdvancedFunctionAnalysisDataRequestor()
 {
 	if (m_func)
@@ -1211,6 +1211,19 @@ AdvancedFunctionAnalysisDataRequestor& AdvancedFunctionAnalysisDataRequestor::op
 }
 
 
+AdvancedFunctionAnalysisDataRequestor& AdvancedFunctionAnalysisDataRequestor::operator=(
+	AdvancedFunctionAnalysisDataRequestor&& req)
+{
+	if (this != &req)
+	{
+		if (m_func)
+			m_func->ReleaseAdvancedAnalysisData();
+		m_func = std::move(req.m_func);
+	}
+	return *this;
+}
+
+
 void AdvancedFunctionAnalysisDataRequestor::SetFunction(Function* func)
 {
 	if (m_func)
@@ -18,6 +18,10 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <system_error>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
@@ -168,6 +172,21 @@ vector<Ref<FunctionGraphBlock>> FunctionGraph::GetBlocksInRegion(int left, int t
 }
 
 
+void FunctionGraph::ReleaseLinesOutsideRegion(int left, int top, int right, int bottom)
+{
+	for (auto& i : m_cachedBlocks)
+	{
+		FunctionGraphBlock* block = i.second;
+		if (!block->HasLines())
+			continue;
+		int x = block->GetX();
+		int y = block->GetY();
+		if ((x >= right) || ((x + block->GetWidth()) <= left) || (y >= bottom) || ((y + block->GetHeight()) <= top))
+			block->ReleaseLines();
+	}
+}
+
+
 bool FunctionGraph::IsOptionSet(BNDisassemblyOption option) const
 {
 	return BNIsFunctionGraphOptionSet(m_graph, option);
@@ -178,3 +197,502 @@ void FunctionGraph::SetOption(BNDisassemblyOption option, bool state)
 {
 	BNSetFunctionGraphOption(m_graph, option, state);
 }
+
+
+static void ParallelFor(size_t count, size_t threads, const function<void(size_t i)>& callback)
+{
+	if (threads == 0)
+		threads = GetWorkerThreadCount();
+	if (threads == 0)
+		threads = thread::hardware_concurrency();
+	threads = min(threads, count);
+	if (threads <= 1)
+	{
+		for (size_t i = 0; i < count; i++)
+			callback(i);
+		return;
+	}
+
+	atomic<size_t> next(0);
+	atomic<bool> aborted(false);
+	mutex errorLock;
+	exception_ptr error;
+	auto worker = [&]() {
+		try
+		{
+			while (!aborted)
+			{
+				size_t i = next++;
+				if (i >= count)
+					break;
+				callback(i);
+			}
+		}
+		catch (...)
+		{
+			unique_lock<mutex> guard(errorLock);
+			if (!error)
+				error = current_exception();
+			aborted = true;
+		}
+	};
+
+	vector<thread> pool;
+	pool.reserve(threads - 1);
+	for (size_t i = 1; i < threads; i++)
+	{
+		try
+		{
+			pool.push_back(thread(worker));
+		}
+		catch (system_error&)
+		{
+			// Out of threads, the workers that did start take the remaining items
+			break;
+		}
+	}
+	worker();
+	for (auto& i : pool)
+		i.join();
+
+	if (error)
+		rethrow_exception(error);
+}
+
+
+static int CountInstructions(BinaryView* view, BasicBlock* block, uint64_t start, uint64_t end)
+{
+	if (end <= start)
+		return 1;
+
+	Ref<Architecture> arch = block->GetArchitecture();
+	vector<uint8_t> data((size_t)(end - start));
+	size_t len = view->Read(data.data(), start, data.size());
+
+	int count = 0;
+	size_t offset = 0;
+	while (offset < len)
+	{
+		InstructionInfo info;
+		count++;
+		if (!arch->GetInstructionInfo(&data[offset], start + offset, len - offset, info) || (info.length == 0))
+			break;
+		offset += info.length;
+	}
+	return max(count, 1);
+}
+
+
+FunctionGraphLayout::FunctionGraphLayout(Function* func, DisassemblySettings* settings, int blockWidth,
+	int horizontalMargin, int verticalMargin, size_t threads): m_settings(settings), m_width(0), m_height(0),
+	m_verticalMargin(verticalMargin), m_componentCount(0)
+{
+	if (!m_settings)
+		m_settings = new DisassemblySettings();
+
+	CFGSnapshot cfg(func);
+	size_t blockCount = cfg.GetBlockCount();
+	size_t edgeCount = cfg.GetEdgeCount();
+	const uint32_t* offsets = cfg.GetOutgoingEdgeOffsets();
+	const uint32_t* targets = cfg.GetEdgeTargets();
+
+	m_blocks.resize(blockCount);
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		Block& block = m_blocks[i];
+		block.block = cfg.GetBlock(i);
+		block.rank = 0;
+		block.component = 0;
+		block.x = 0;
+		block.y = 0;
+		block.width = block.block ? blockWidth : 0;
+		block.height = 0;
+	}
+
+	// Sizing decodes every block, which dominates the cost for large functions, so it is spread over all
+	// blocks rather than over components
+	Ref<BinaryView> view = func->GetView();
+	ParallelFor(blockCount, threads, [&](size_t i) {
+		if (m_blocks[i].block)
+			m_blocks[i].height = CountInstructions(view, m_blocks[i].block, cfg.GetBlockStarts()[i], cfg.GetBlockEnds()[i]);
+	});
+
+	// Split the graph into weakly connected components, starting with the one holding the entry block. The
+	// text of the entry block starts with the function type.
+	vector<uint32_t> roots;
+	uint64_t entry = func->GetStart();
+	for (uint32_t i = 0; i < blockCount; i++)
+	{
+		if (m_blocks[i].block && (cfg.GetBlockStarts()[i] == entry))
+		{
+			m_blocks[i].height += (int)func->GetTypeTokens(m_settings).size();
+			roots.push_back(i);
+			break;
+		}
+	}
+	for (uint32_t i = 0; i < blockCount; i++)
+		roots.push_back(i);
+
+	const uint32_t none = CFGSnapshot::NoBlock;
+	vector<uint32_t> componentOf(blockCount, none);
+	vector<vector<uint32_t>> components;
+	vector<uint32_t> worklist;
+	for (auto root : roots)
+	{
+		if (!m_blocks[root].block || (componentOf[root] != none))
+			continue;
+
+		uint32_t component = (uint32_t)components.size();
+		components.push_back(vector<uint32_t>());
+		componentOf[root] = component;
+		worklist.push_back(root);
+		while (!worklist.empty())
+		{
+			uint32_t block = worklist.back();
+			worklist.pop_back();
+			components.back().push_back(block);
+
+			size_t count;
+			const uint32_t* neighbors = cfg.GetSuccessors(block, count);
+			for (size_t i = 0; i < count; i++)
+			{
+				if ((neighbors[i] != none) && (componentOf[neighbors[i]] == none))
+				{
+					componentOf[neighbors[i]] = component;
+					worklist.push_back(neighbors[i]);
+				}
+			}
+			neighbors = cfg.GetPredecessors(block, count);
+			for (size_t i = 0; i < count; i++)
+			{
+				if (componentOf[neighbors[i]] == none)
+				{
+					componentOf[neighbors[i]] = component;
+					worklist.push_back(neighbors[i]);
+				}
+			}
+		}
+	}
+
+	// Components share no blocks or edges, so they are ranked and ordered concurrently, each on a single
+	// thread. The largest go first so that one large component does not start last.
+	vector<size_t> order(components.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(),
+		[&](size_t a, size_t b) { return components[a].size() > components[b].size(); });
+
+	vector<uint8_t> backEdges(edgeCount, 0);
+	vector<uint8_t> state(blockCount, 0);
+	vector<uint32_t> position(blockCount, 0);
+	vector<int> widths(components.size(), 0);
+	ParallelFor(order.size(), threads, [&](size_t i) {
+		size_t component = order[i];
+		LayoutComponent(cfg, components[component], backEdges, state, position, blockWidth, horizontalMargin,
+			widths[component]);
+	});
+
+	int x = 0;
+	for (size_t i = 0; i < components.size(); i++)
+	{
+		for (auto block : components[i])
+		{
+			m_blocks[block].x += x;
+			m_blocks[block].component = (uint32_t)i;
+		}
+		x += widths[i] + horizontalMargin;
+	}
+	m_width = components.empty() ? 0 : (x - horizontalMargin);
+	m_componentCount = components.size();
+
+	const uint32_t* sources = cfg.GetEdgeSources();
+	const uint8_t* types = cfg.GetEdgeTypes();
+	m_edges.reserve(edgeCount);
+	for (uint32_t source = 0; source < blockCount; source++)
+	{
+		for (uint32_t i = offsets[source]; i < offsets[source + 1]; i++)
+		{
+			if (targets[i] == none)
+				continue;
+
+			Edge edge;
+			edge.source = sources[i];
+			edge.target = targets[i];
+			edge.type = (BNBranchType)types[i];
+			edge.backEdge = backEdges[i] != 0;
+			m_edges.push_back(move(edge));
+		}
+	}
+
+	PlaceRanks();
+}
+
+
+FunctionGraphLayout::~FunctionGraphLayout()
+{
+	DisassemblyTextCache::ReleaseOwner(this);
+}
+
+
+void FunctionGraphLayout::LayoutComponent(const CFGSnapshot& cfg, const vector<uint32_t>& blocks,
+	vector<uint8_t>& backEdges, vector<uint8_t>& state, vector<uint32_t>& position, int blockWidth,
+	int horizontalMargin, int& width)
+{
+	const uint32_t none = CFGSnapshot::NoBlock;
+	const uint32_t* offsets = cfg.GetOutgoingEdgeOffsets();
+	const uint32_t* targets = cfg.GetEdgeTargets();
+
+	// Depth first search from the first block, classifying edges into blocks still on the stack as back edges.
+	// Reverse postorder is then a topological order of the remaining edges.
+	enum VisitState : uint8_t { Unvisited, Active, Done };
+	vector<uint32_t> postorder;
+	postorder.reserve(blocks.size());
+	vector<pair<uint32_t, uint32_t>> stack;
+	for (auto root : blocks)
+	{
+		if (state[root] != Unvisited)
+			continue;
+		state[root] = Active;
+		stack.push_back(make_pair(root, offsets[root]));
+		while (!stack.empty())
+		{
+			uint32_t block = stack.back().first;
+			uint32_t edge = stack.back().second;
+			if (edge < offsets[block + 1])
+			{
+				stack.back().second++;
+				uint32_t target = targets[edge];
+				if (target == none)
+					continue;
+				uint8_t& targetState = state[target];
+				if (targetState == Active)
+				{
+					backEdges[edge] = 1;
+				}
+				else if (targetState == Unvisited)
+				{
+					targetState = Active;
+					stack.push_back(make_pair(target, offsets[target]));
+				}
+				continue;
+			}
+			state[block] = Done;
+			postorder.push_back(block);
+			stack.pop_back();
+		}
+	}
+
+	// Longest path ranks over forward edges
+	uint32_t rankCount = 0;
+	for (auto i = postorder.rbegin(); i != postorder.rend(); ++i)
+	{
+		uint32_t block = *i;
+		uint32_t rank = m_blocks[block].rank;
+		rankCount = max(rankCount, rank + 1);
+		for (uint32_t edge = offsets[block]; edge < offsets[block + 1]; edge++)
+		{
+			if ((targets[edge] == none) || backEdges[edge])
+				continue;
+			m_blocks[targets[edge]].rank = max(m_blocks[targets[edge]].rank, rank + 1);
+		}
+	}
+
+	// Order each rank by the mean position of its forward predecessors, one sweep from the top
+	vector<vector<uint32_t>> ranks(rankCount);
+	for (auto i = postorder.rbegin(); i != postorder.rend(); ++i)
+		ranks[m_blocks[*i].rank].push_back(*i);
+	const uint32_t* sources = cfg.GetEdgeSources();
+	const uint32_t* incoming = cfg.GetIncomingEdges();
+	const uint32_t* incomingOffsets = cfg.GetIncomingEdgeOffsets();
+	for (uint32_t rank = 0; rank < rankCount; rank++)
+	{
+		vector<pair<double, uint32_t>> keyed;
+		keyed.reserve(ranks[rank].size());
+		for (size_t i = 0; i < ranks[rank].size(); i++)
+		{
+			uint32_t block = ranks[rank][i];
+			double sum = 0;
+			size_t count = 0;
+			for (uint32_t j = incomingOffsets[block]; j < incomingOffsets[block + 1]; j++)
+			{
+				if (backEdges[incoming[j]])
+					continue;
+				sum += position[sources[incoming[j]]];
+				count++;
+			}
+			keyed.push_back(make_pair(count ? (sum / (double)count) : (double)i, block));
+		}
+		stable_sort(keyed.begin(), keyed.end(),
+			[](const pair<double, uint32_t>& a, const pair<double, uint32_t>& b) { return a.first < b.first; });
+		for (size_t i = 0; i < keyed.size(); i++)
+		{
+			ranks[rank][i] = keyed[i].second;
+			position[keyed[i].second] = (uint32_t)i;
+		}
+	}
+
+	// Center each rank horizontally. Vertical positions depend on block heights and are assigned by PlaceRanks.
+	width = 0;
+	for (auto& rank : ranks)
+		width = max(width, ((int)rank.size() * (blockWidth + horizontalMargin)) - horizontalMargin);
+	for (auto& rank : ranks)
+	{
+		int rankWidth = ((int)rank.size() * (blockWidth + horizontalMargin)) - horizontalMargin;
+		int x = (width - rankWidth) / 2;
+		for (auto block : rank)
+		{
+			m_blocks[block].x = x;
+			x += blockWidth + horizontalMargin;
+		}
+	}
+}
+
+
+void FunctionGraphLayout::PlaceRanks()
+{
+	// Stack the ranks of each component vertically, each as tall as its tallest block
+	vector<vector<int>> rankHeights(m_componentCount);
+	for (auto& block : m_blocks)
+	{
+		if (!block.block)
+			continue;
+		vector<int>& heights = rankHeights[block.component];
+		if (heights.size() <= block.rank)
+			heights.resize(block.rank + 1, 0);
+		heights[block.rank] = max(heights[block.rank], block.height);
+	}
+
+	vector<vector<int>> rankTops(m_componentCount);
+	m_height = 0;
+	for (size_t i = 0; i < m_componentCount; i++)
+	{
+		int y = 0;
+		for (auto height : rankHeights[i])
+		{
+			rankTops[i].push_back(y);
+			y += height + m_verticalMargin;
+		}
+		if (!rankHeights[i].empty())
+			m_height = max(m_height, y - m_verticalMargin);
+	}
+
+	for (auto& block : m_blocks)
+	{
+		if (block.block)
+			block.y = rankTops[block.component][block.rank];
+	}
+
+	float gap = (float)m_verticalMargin / 2.0f;
+	for (auto& edge : m_edges)
+	{
+		const Block& from = m_blocks[edge.source];
+		const Block& to = m_blocks[edge.target];
+		float fromX = (float)from.x + ((float)from.width / 2.0f);
+		float fromY = (float)(from.y + from.height);
+		float toX = (float)to.x + ((float)to.width / 2.0f);
+		float toY = (float)to.y;
+
+		edge.points.clear();
+		edge.points.push_back(BNPoint{fromX, fromY});
+		edge.points.push_back(BNPoint{fromX, fromY + gap});
+		edge.points.push_back(BNPoint{toX, toY - gap});
+		edge.points.push_back(BNPoint{toX, toY});
+	}
+}
+
+
+vector<uint32_t> FunctionGraphLayout::GetBlocksInRegion(int left, int top, int right, int bottom) const
+{
+	vector<uint32_t> result;
+	for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); i++)
+	{
+		const Block& block = m_blocks[i];
+		if (!block.block)
+			continue;
+		if ((block.x < right) && ((block.x + block.width) > left) && (block.y < bottom) &&
+			((block.y + block.height) > top))
+			result.push_back(i);
+	}
+	return result;
+}
+
+
+vector<uint32_t> FunctionGraphLayout::MaterializeRegion(int left, int top, int right, int bottom, size_t threads)
+{
+	// Heights were estimated from instruction counts, so the blocks in the region are resized to their text.
+	// That moves the ranks below them, which can bring more blocks into the region, so repeat until every
+	// block in the region has been sized.
+	vector<uint8_t> sized(m_blocks.size(), 0);
+	while (true)
+	{
+		vector<uint32_t> result = GetBlocksInRegion(left, top, right, bottom);
+		vector<uint32_t> pending;
+		for (auto i : result)
+		{
+			if (!sized[i])
+				pending.push_back(i);
+		}
+		if (pending.empty())
+			return result;
+
+		// Text that is already cached, including text requested through GetLines, is looked up rather than
+		// generated again
+		vector<int> heights(pending.size(), 0);
+		ParallelFor(pending.size(), threads, [&](size_t i) { heights[i] = (int)GetLines(pending[i])->size(); });
+
+		bool changed = false;
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			sized[pending[i]] = 1;
+			int height = max(heights[i], 1);
+			if (m_blocks[pending[i]].height != height)
+			{
+				m_blocks[pending[i]].height = height;
+				changed = true;
+			}
+		}
+		if (changed)
+			PlaceRanks();
+	}
+}
+
+
+DisassemblyTextCache::Lines FunctionGraphLayout::GetLines(uint32_t block)
+{
+	DisassemblyTextCache::Lines cached = DisassemblyTextCache::Lookup(this, block);
+	if (cached)
+		return cached;
+
+	// Generated outside of any lock, so that blocks are materialized concurrently
+	DisassemblyTextCache::Lines lines;
+	if (m_blocks[block].block)
+		lines = make_shared<vector<DisassemblyTextLine>>(m_blocks[block].block->GetDisassemblyText(m_settings));
+	else
+		lines = make_shared<vector<DisassemblyTextLine>>();
+	return DisassemblyTextCache::Store(this, block, lines);
+}
+
+
+bool FunctionGraphLayout::IsMaterialized(uint32_t block) const
+{
+	return DisassemblyTextCache::Contains(this, block);
+}
+
+
+void FunctionGraphLayout::ReleaseLines()
+{
+	DisassemblyTextCache::ReleaseOwner(this);
+}
+
+
+void FunctionGraphLayout::ReleaseLinesOutsideRegion(int left, int top, int right, int bottom)
+{
+	vector<bool> inside(m_blocks.size(), false);
+	for (auto i : GetBlocksInRegion(left, top, right, bottom))
+		inside[i] = true;
+	for (uint32_t i = 0; i < (uint32_t)m_blocks.size(); i++)
+	{
+		if (!inside[i])
+			DisassemblyTextCache::Release(this, i);
+	}
+}
@@ -18,20 +18,216 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <list>
+#include <unordered_set>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
+namespace
+{
+	struct CachedText
+	{
+		const void* owner;
+		uint64_t key;
+		DisassemblyTextCache::Lines lines;
+		size_t size;
+	};
+
+	struct CachedTextKeyHash
+	{
+		size_t operator()(const pair<const void*, uint64_t>& key) const
+		{
+			return hash<const void*>()(key.first) ^ (hash<uint64_t>()(key.second) * 31);
+		}
+	};
+
+	struct DisassemblyTextCacheState
+	{
+		mutex lock;
+		// Most recently used first
+		list<CachedText> entries;
+		unordered_map<pair<const void*, uint64_t>, list<CachedText>::iterator, CachedTextKeyHash> index;
+		// Keys stored for each owner, so that an owner's text is released without scanning every entry
+		unordered_map<const void*, unordered_set<uint64_t>> owners;
+		size_t usage;
+		size_t limit;
+
+		DisassemblyTextCacheState(): usage(0), limit(128 * 1024 * 1024) {}
+	};
+
+	DisassemblyTextCacheState& GetDisassemblyTextCacheState()
+	{
+		// Never destroyed, so that graphs released during process exit can still remove their text
+		static DisassemblyTextCacheState* state = new DisassemblyTextCacheState;
+		return *state;
+	}
+
+	// Removes an entry from the cache. The text is moved into removed so that it is freed after the lock is
+	// released.
+	void RemoveDisassemblyText(DisassemblyTextCacheState& state, list<CachedText>::iterator entry,
+		vector<DisassemblyTextCache::Lines>& removed)
+	{
+		state.usage -= entry->size;
+		removed.push_back(move(entry->lines));
+		state.index.erase(make_pair(entry->owner, entry->key));
+		auto owner = state.owners.find(entry->owner);
+		if (owner != state.owners.end())
+		{
+			owner->second.erase(entry->key);
+			if (owner->second.empty())
+				state.owners.erase(owner);
+		}
+		state.entries.erase(entry);
+	}
+
+	// Removes least recently used entries other than keep until usage is within the limit
+	void EvictDisassemblyText(DisassemblyTextCacheState& state, const CachedText* keep,
+		vector<DisassemblyTextCache::Lines>& evicted)
+	{
+		while ((state.usage > state.limit) && !state.entries.empty())
+		{
+			auto victim = state.entries.end();
+			--victim;
+			if (&*victim == keep)
+				break;
+			RemoveDisassemblyText(state, victim, evicted);
+		}
+	}
+}
+
+
+DisassemblyTextCache::Lines DisassemblyTextCache::Lookup(const void* owner, uint64_t key)
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	unique_lock<mutex> lock(state.lock);
+	auto i = state.index.find(make_pair(owner, key));
+	if (i == state.index.end())
+		return nullptr;
+	state.entries.splice(state.entries.begin(), state.entries, i->second);
+	return i->second->lines;
+}
+
+
+bool DisassemblyTextCache::Contains(const void* owner, uint64_t key)
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	unique_lock<mutex> lock(state.lock);
+	return state.index.find(make_pair(owner, key)) != state.index.end();
+}
+
+
+DisassemblyTextCache::Lines DisassemblyTextCache::Store(const void* owner, uint64_t key, const Lines& lines)
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	vector<Lines> evicted;
+	unique_lock<mutex> lock(state.lock);
+	auto i = state.index.find(make_pair(owner, key));
+	if (i != state.index.end())
+	{
+		// Another thread generated the same text first, keep that copy
+		state.entries.splice(state.entries.begin(), state.entries, i->second);
+		return i->second->lines;
+	}
+
+	CachedText entry;
+	entry.owner = owner;
+	entry.key = key;
+	entry.lines = lines;
+	entry.size = EstimateSize(*lines);
+	state.entries.push_front(entry);
+	state.index[make_pair(owner, key)] = state.entries.begin();
+	state.owners[owner].insert(key);
+	state.usage += entry.size;
+	EvictDisassemblyText(state, &state.entries.front(), evicted);
+	return lines;
+}
+
+
+void DisassemblyTextCache::Release(const void* owner, uint64_t key)
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	vector<Lines> released;
+	unique_lock<mutex> lock(state.lock);
+	auto i = state.index.find(make_pair(owner, key));
+	if (i == state.index.end())
+		return;
+	RemoveDisassemblyText(state, i->second, released);
+}
+
+
+void DisassemblyTextCache::ReleaseOwner(const void* owner)
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	vector<Lines> released;
+	unique_lock<mutex> lock(state.lock);
+	auto keys = state.owners.find(owner);
+	if (keys == state.owners.end())
+		return;
+
+	vector<list<CachedText>::iterator> entries;
+	entries.reserve(keys->second.size());
+	for (auto key : keys->second)
+		entries.push_back(state.index[make_pair(owner, key)]);
+	for (auto i : entries)
+		RemoveDisassemblyText(state, i, released);
+}
+
+
+void DisassemblyTextCache::SetLimit(size_t bytes)
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	vector<Lines> evicted;
+	unique_lock<mutex> lock(state.lock);
+	state.limit = bytes;
+	EvictDisassemblyText(state, nullptr, evicted);
+}
+
+
+size_t DisassemblyTextCache::GetLimit()
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	unique_lock<mutex> lock(state.lock);
+	return state.limit;
+}
+
+
+size_t DisassemblyTextCache::GetUsage()
+{
+	DisassemblyTextCacheState& state = GetDisassemblyTextCacheState();
+	unique_lock<mutex> lock(state.lock);
+	return state.usage;
+}
+
+
+size_t DisassemblyTextCache::EstimateSize(const vector<DisassemblyTextLine>& lines)
+{
+	size_t result = sizeof(lines) + (lines.capacity() * sizeof(DisassemblyTextLine));
+	for (auto& line : lines)
+	{
+		result += line.tokens.capacity() * sizeof(InstructionTextToken);
+		for (auto& token : line.tokens)
+			result += token.text.capacity();
+	}
+	return result;
+}
+
+
 FunctionGraphBlock::FunctionGraphBlock(BNFunctionGraphBlock* block)
 {
 	m_object = block;
-	m_cachedLinesValid = false;
 	m_cachedEdgesValid = false;
 }
 
 
+FunctionGraphBlock::~FunctionGraphBlock()
+{
+	DisassemblyTextCache::Release(this, 0);
+}
+
+
 Ref<BasicBlock> FunctionGraphBlock::GetBasicBlock() const
 {
 	return new BasicBlock(BNGetFunctionGraphBasicBlock(m_object));
@@ -80,39 +276,39 @@ int FunctionGraphBlock::GetHeight() const
 }
 
 
-const vector<DisassemblyTextLine>& FunctionGraphBlock::GetLines()
+DisassemblyTextCache::Lines FunctionGraphBlock::GetLines()
 {
-	if (m_cachedLinesValid)
-		return m_cachedLines;
+	DisassemblyTextCache::Lines cached = DisassemblyTextCache::Lookup(this, 0);
+	if (cached)
+		return cached;
 
 	size_t count;
 	BNDisassemblyTextLine* lines = BNGetFunctionGraphBlockLines(m_object, &count);
 
-	vector<DisassemblyTextLine> result;
+	shared_ptr<vector<DisassemblyTextLine>> result = make_shared<vector<DisassemblyTextLine>>();
+	result->reserve(count);
 	for (size_t i = 0; i < count; i++)
 	{
 		DisassemblyTextLine line;
 		line.addr = lines[i].addr;
-		for (size_t j = 0; j < lines[i].count; j++)
-		{
-			InstructionTextToken token;
-			token.type = lines[i].tokens[j].type;
-			token.text = lines[i].tokens[j].text;
-			token.value = lines[i].tokens[j].value;
-			token.size = lines[i].tokens[j].size;
-			token.operand = lines[i].tokens[j].operand;
-			token.context = lines[i].tokens[j].context;
-			token.confidence = lines[i].tokens[j].confidence;
-			token.address = lines[i].tokens[j].address;
-			line.tokens.push_back(token);
-		}
-		result.push_back(line);
+		line.tokens = InstructionTextToken::ConvertInstructionTextTokenList(lines[i].tokens, lines[i].count);
+		result->push_back(move(line));
 	}
 
 	BNFreeDisassemblyTextLines(lines, count);
-	m_cachedLines = result;
-	m_cachedLinesValid = true;
-	return m_cachedLines;
+	return DisassemblyTextCache::Store(this, 0, result);
+}
+
+
+bool FunctionGraphBlock::HasLines() const
+{
+	return DisassemblyTextCache::Contains(this, 0);
+}
+
+
+void FunctionGraphBlock::ReleaseLines()
+{
+	DisassemblyTextCache::Release(this, 0);
 }
 
 
@@ -18,6 +18,7 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
 #include "lowlevelilinstruction.h"
 
@@ -389,20 +390,7 @@ bool LowLevelILFunction::GetExprText(Architecture* arch, ExprId expr, vector<Ins
 	if (!BNGetLowLevelILExprText(m_object, arch->GetObject(), expr, &list, &count))
 		return false;
 
-	tokens.clear();
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = list[i].type;
-		token.text = list[i].text;
-		token.value = list[i].value;
-		token.size = list[i].size;
-		token.operand = list[i].operand;
-		token.context = list[i].context;
-		token.confidence = list[i].confidence;
-		token.address = list[i].address;
-		tokens.push_back(token);
-	}
+	tokens = InstructionTextToken::ConvertInstructionTextTokenList(list, count);
 
 	BNFreeInstructionText(list, count);
 	return true;
@@ -418,20 +406,7 @@ bool LowLevelILFunction::GetInstructionText(Function* func, Architecture* arch,
 		instr, &list, &count))
 		return false;
 
-	tokens.clear();
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = list[i].type;
-		token.text = list[i].text;
-		token.value = list[i].value;
-		token.size = list[i].size;
-		token.operand = list[i].operand;
-		token.context = list[i].context;
-		token.confidence = list[i].confidence;
-		token.address = list[i].address;
-		tokens.push_back(token);
-	}
+	tokens = InstructionTextToken::ConvertInstructionTextTokenList(list, count);
 
 	BNFreeInstructionText(list, count);
 	return true;
@@ -456,8 +431,9 @@ vector<Ref<BasicBlock>> LowLevelILFunction::GetBasicBlocks() const
 	BNBasicBlock** blocks = BNGetLowLevelILBasicBlockList(m_object, &count);
 
 	vector<Ref<BasicBlock>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.push_back(Ref<BasicBlock>::Adopt(new BasicBlock(BNNewBasicBlockReference(blocks[i]))));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
@@ -730,3 +706,441 @@ size_t LowLevelILFunction::GetMappedMediumLevelILExprIndex(size_t expr) const
 {
 	return BNGetMappedMediumLevelILExprIndex(m_object, expr);
 }
+
+
+LowLevelILSnapshot LowLevelILFunction::GetSnapshot() const
+{
+	return LowLevelILSnapshot(const_cast<LowLevelILFunction*>(this));
+}
+
+
+LowLevelILSnapshot::LowLevelILSnapshot()
+{
+}
+
+
+LowLevelILSnapshot::LowLevelILSnapshot(LowLevelILFunction* func): m_function(func)
+{
+	BNLowLevelILFunction* il = func->GetObject();
+
+	size_t exprCount = BNGetLowLevelILExprCount(il);
+	m_operations.resize(exprCount);
+	m_sizes.resize(exprCount);
+	m_flags.resize(exprCount);
+	m_sourceOperands.resize(exprCount);
+	m_operands.resize(exprCount * OperandsPerExpr);
+	m_addresses.resize(exprCount);
+	for (size_t i = 0; i < exprCount; i++)
+	{
+		BNLowLevelILInstruction expr = BNGetLowLevelILByIndex(il, i);
+		m_operations[i] = expr.operation;
+		m_sizes[i] = expr.size;
+		m_flags[i] = expr.flags;
+		m_sourceOperands[i] = expr.sourceOperand;
+		memcpy(&m_operands[i * OperandsPerExpr], expr.operands, sizeof(expr.operands));
+		m_addresses[i] = expr.address;
+	}
+
+	size_t instrCount = BNGetLowLevelILInstructionCount(il);
+	m_instructionExprs.resize(instrCount);
+	for (size_t i = 0; i < instrCount; i++)
+		m_instructionExprs[i] = BNGetLowLevelILIndexForInstruction(il, i);
+}
+
+
+LowLevelILInstruction LowLevelILSnapshotExpr::ToInstruction() const
+{
+	return m_snapshot->GetFunction()->GetExpr(m_expr);
+}
+
+
+LowLevelILLiftCache::LowLevelILLiftCache(size_t maxInstructionLength, size_t addressSize, size_t maxEntries,
+	uint64_t granularity): m_shardCapacity(1), m_maxInstructionLength(maxInstructionLength),
+	m_granularity(granularity), m_hits(0), m_misses(0), m_uncacheable(0)
+{
+	if (m_maxInstructionLength == 0)
+		m_maxInstructionLength = 1;
+	if (m_granularity == 0)
+		m_granularity = 1;
+	m_addressMask = (addressSize >= 8) ? (uint64_t)-1 : ((1ULL << (addressSize * 8)) - 1);
+
+	// The verification lift is shifted far enough that relative operands cannot be confused with small
+	// constants, but must stay representable in the address space. A zero shift disables caching.
+	m_shift = (m_granularity << 8) & m_addressMask;
+	if (m_shift == 0)
+		m_shift = m_granularity & m_addressMask;
+
+	// The second verification lift also flips the top address bit, so that operands built from the high bits
+	// of the address (such as a MIPS region jump) are not mistaken for constants or plain relative values
+	m_highShift = (m_shift + (m_addressMask >> 1) + 1) & m_addressMask;
+	if (m_highShift == m_shift)
+		m_highShift = 0;
+
+	SetCapacity(maxEntries);
+}
+
+
+void LowLevelILLiftCache::SetCapacity(size_t maxEntries)
+{
+	size_t shardCapacity = (maxEntries + ShardCount - 1) / ShardCount;
+	if (shardCapacity == 0)
+		shardCapacity = 1;
+	m_shardCapacity = shardCapacity;
+
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		while (shard.entries.size() > shardCapacity)
+		{
+			shard.index.erase(shard.entries.back()->key);
+			shard.entries.pop_back();
+		}
+	}
+}
+
+
+size_t LowLevelILLiftCache::GetCapacity() const
+{
+	return m_shardCapacity * ShardCount;
+}
+
+
+size_t LowLevelILLiftCache::GetEntryCount()
+{
+	size_t count = 0;
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		count += shard.entries.size();
+	}
+	return count;
+}
+
+
+LowLevelILLiftCache::Key LowLevelILLiftCache::GetKey(const uint8_t* data, uint64_t addr, size_t len) const
+{
+	Key key;
+	key.length = (len < m_maxInstructionLength) ? len : m_maxInstructionLength;
+	key.offset = addr % m_granularity;
+
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < key.length; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	key.hash = hash;
+	return key;
+}
+
+
+LowLevelILLiftCache::Shard& LowLevelILLiftCache::GetShard(const Key& key)
+{
+	return m_shards[(size_t)(key.hash ^ (key.hash >> 32)) % ShardCount];
+}
+
+
+shared_ptr<const LowLevelILLiftCache::Template> LowLevelILLiftCache::Find(const Key& key, const uint8_t* data)
+{
+	Shard& shard = GetShard(key);
+	unique_lock<mutex> lock(shard.mutex);
+	auto i = shard.index.find(key);
+	if (i == shard.index.end())
+		return nullptr;
+
+	const Template& lift = **i->second;
+	if ((key.length != 0) && (memcmp(&lift.bytes[0], data, key.length) != 0))
+		return nullptr;
+
+	shard.entries.splice(shard.entries.begin(), shard.entries, i->second);
+	return *i->second;
+}
+
+
+void LowLevelILLiftCache::Store(const shared_ptr<const Template>& lift)
+{
+	Shard& shard = GetShard(lift->key);
+	unique_lock<mutex> lock(shard.mutex);
+	auto i = shard.index.find(lift->key);
+	if (i != shard.index.end())
+	{
+		// Another thread lifted the same bytes, or a hash collision replaces the previous pattern
+		*i->second = lift;
+		shard.entries.splice(shard.entries.begin(), shard.entries, i->second);
+		return;
+	}
+
+	size_t capacity = m_shardCapacity;
+	while (shard.entries.size() >= capacity)
+	{
+		shard.index.erase(shard.entries.back()->key);
+		shard.entries.pop_back();
+	}
+	shard.entries.push_front(lift);
+	shard.index[lift->key] = shard.entries.begin();
+}
+
+
+bool LowLevelILLiftCache::Capture(LowLevelILFunction& il, uint64_t addr, size_t startExpr, size_t startInstr,
+	Template& result)
+{
+	size_t endExpr = il.GetExprCount();
+	size_t endInstr = il.GetInstructionCount();
+
+	result.exprs.clear();
+	result.exprs.reserve(endExpr - startExpr);
+	for (size_t i = startExpr; i < endExpr; i++)
+	{
+		BNLowLevelILInstruction instr = il.GetRawExpr(i);
+		if (!IsLowLevelILOperationValidForOperands(instr.operation))
+			return false;
+
+		Expr expr;
+		expr.operation = instr.operation;
+		expr.size = instr.size;
+		expr.flags = instr.flags;
+		expr.sourceOperand = instr.sourceOperand;
+		expr.addressOffset = instr.address - addr;
+		for (size_t j = 0; j < 4; j++)
+		{
+			expr.operands[j] = instr.operands[j];
+			expr.kinds[j] = ConstantOperand;
+		}
+
+		const LowLevelILOperationOperandUsages& usages =
+			LowLevelILOperandTables::operationOperandUsage[instr.operation];
+		for (size_t j = 0; j < usages.count; j++)
+		{
+			int operand = GetLowLevelILOperandIndex(instr.operation, usages.usages[j]);
+			if ((operand < 0) || (operand >= 4))
+				return false;
+
+			switch (GetLowLevelILOperandType(usages.usages[j]))
+			{
+			case ExprLowLevelOperand:
+				// Only subexpressions created by this lift can be replayed
+				if ((instr.operands[operand] < startExpr) || (instr.operands[operand] >= i))
+					return false;
+				expr.operands[operand] -= startExpr;
+				expr.kinds[operand] = ExprOperand;
+				break;
+			case IntegerLowLevelOperand:
+			case RegisterLowLevelOperand:
+			case FlagLowLevelOperand:
+			case FlagConditionLowLevelOperand:
+				break;
+			default:
+				// Labels and operand lists refer to state outside of the expressions themselves
+				return false;
+			}
+		}
+
+		result.exprs.push_back(expr);
+	}
+
+	result.instructions.clear();
+	for (size_t i = startInstr; i < endInstr; i++)
+	{
+		size_t expr = il.GetIndexForInstruction(i);
+		if ((expr < startExpr) || (expr >= endExpr))
+			return false;
+		result.instructions.push_back(expr - startExpr);
+	}
+	return true;
+}
+
+
+bool LowLevelILLiftCache::Merge(Template& lift, const Template& shifted, uint64_t shift, bool classify) const
+{
+	if ((lift.result != shifted.result) || (lift.length != shifted.length) ||
+		(lift.exprs.size() != shifted.exprs.size()) || (lift.instructions != shifted.instructions))
+		return false;
+
+	for (size_t i = 0; i < lift.exprs.size(); i++)
+	{
+		Expr& expr = lift.exprs[i];
+		const Expr& other = shifted.exprs[i];
+		if ((expr.operation != other.operation) || (expr.size != other.size) || (expr.flags != other.flags) ||
+			(expr.sourceOperand != other.sourceOperand) || (expr.addressOffset != other.addressOffset))
+			return false;
+
+		for (size_t j = 0; j < 4; j++)
+		{
+			bool isExpr = expr.kinds[j] == ExprOperand;
+			if (isExpr != (other.kinds[j] == ExprOperand))
+				return false;
+
+			uint64_t diff = other.operands[j] - expr.operands[j];
+			if (isExpr)
+			{
+				if (diff != 0)
+					return false;
+				continue;
+			}
+
+			uint8_t kind;
+			if (diff == 0)
+				kind = ConstantOperand;
+			else if (diff == shift)
+				kind = RelativeOperand;
+			else if ((diff & m_addressMask) == shift)
+				kind = MaskedRelativeOperand;
+			else
+				return false;
+
+			if (classify)
+			{
+				expr.kinds[j] = kind;
+			}
+			else if (kind != expr.kinds[j])
+			{
+				// Both relative forms replay the same value within the address space, but a constant in one
+				// lift must be a constant in every lift
+				if ((kind == ConstantOperand) || (expr.kinds[j] == ConstantOperand))
+					return false;
+				expr.kinds[j] = MaskedRelativeOperand;
+			}
+		}
+	}
+	return true;
+}
+
+
+bool LowLevelILLiftCache::Verify(Architecture* arch, const uint8_t* data, uint64_t addr, uint64_t shift,
+	size_t maxLen, Template& lift, bool classify)
+{
+	Ref<LowLevelILFunction> scratch = arch->GetScratchLowLevelILFunction();
+	uint64_t shiftedAddr = (addr + shift) & m_addressMask;
+	scratch->SetCurrentAddress(arch, shiftedAddr);
+
+	Template shifted;
+	size_t shiftedExpr = scratch->GetExprCount();
+	size_t shiftedInstr = scratch->GetInstructionCount();
+	shifted.length = maxLen;
+	shifted.result = arch->GetInstructionLowLevelIL(data, shiftedAddr, shifted.length, *scratch);
+
+	// Lifters that move the current address (for example into a delay slot) cannot be replayed
+	return (scratch->GetCurrentAddress() == shiftedAddr) &&
+		Capture(*scratch, shiftedAddr, shiftedExpr, shiftedInstr, shifted) && Merge(lift, shifted, shift, classify);
+}
+
+
+void LowLevelILLiftCache::Replay(const Template& lift, uint64_t addr, LowLevelILFunction& il) const
+{
+	uint64_t rebase = addr - lift.address;
+	vector<ExprId> exprs;
+	exprs.reserve(lift.exprs.size());
+	for (auto& i : lift.exprs)
+	{
+		uint64_t operands[4];
+		for (size_t j = 0; j < 4; j++)
+		{
+			switch (i.kinds[j])
+			{
+			case ExprOperand:
+				operands[j] = exprs[(size_t)i.operands[j]];
+				break;
+			case RelativeOperand:
+				operands[j] = i.operands[j] + rebase;
+				break;
+			case MaskedRelativeOperand:
+				operands[j] = (i.operands[j] + rebase) & m_addressMask;
+				break;
+			default:
+				operands[j] = i.operands[j];
+				break;
+			}
+		}
+
+		exprs.push_back(il.AddExprWithLocation(i.operation, addr + i.addressOffset, i.sourceOperand, i.size,
+			i.flags, operands[0], operands[1], operands[2], operands[3]));
+	}
+
+	for (auto i : lift.instructions)
+		il.AddInstruction(exprs[i]);
+}
+
+
+bool LowLevelILLiftCache::GetInstructionLowLevelIL(Architecture* arch, const uint8_t* data, uint64_t addr,
+	size_t& len, LowLevelILFunction& il)
+{
+	// Key on the decoded instruction, so that the bytes after it do not take part in the lookup
+	InstructionInfo info;
+	if ((!arch->GetCachedInstructionInfo(data, addr, len, info)) || (info.length == 0) || (info.length > len) ||
+		(info.length > m_maxInstructionLength))
+	{
+		m_misses++;
+		m_uncacheable++;
+		return arch->GetInstructionLowLevelIL(data, addr, len, il);
+	}
+
+	Key key = GetKey(data, addr, info.length);
+	shared_ptr<const Template> lift = Find(key, data);
+	if (lift && lift->cacheable)
+	{
+		m_hits++;
+		Replay(*lift, addr, il);
+		len = lift->length;
+		return lift->result;
+	}
+
+	m_misses++;
+	if (lift)
+	{
+		// Already known not to be replayable
+		m_uncacheable++;
+		return arch->GetInstructionLowLevelIL(data, addr, len, il);
+	}
+
+	size_t maxLen = len;
+	uint64_t currentAddr = il.GetCurrentAddress();
+	size_t startExpr = il.GetExprCount();
+	size_t startInstr = il.GetInstructionCount();
+	bool result = arch->GetInstructionLowLevelIL(data, addr, len, il);
+
+	shared_ptr<Template> recorded = make_shared<Template>();
+	recorded->key = key;
+	recorded->bytes.assign(data, data + key.length);
+	recorded->address = addr;
+	recorded->cacheable = false;
+	recorded->result = result;
+	recorded->length = len;
+
+	// Lifters that move the current address (for example into a delay slot) cannot be replayed, and neither can
+	// lifts that consume a different length than was decoded, as the key would not describe them. The
+	// instruction is lifted again at shifted addresses to tell address-relative operands from constants.
+	if ((m_shift != 0) && (len == key.length) && (il.GetCurrentAddress() == currentAddr) &&
+		Capture(il, addr, startExpr, startInstr, *recorded) &&
+		Verify(arch, data, addr, m_shift, maxLen, *recorded, true) &&
+		((m_highShift == 0) || Verify(arch, data, addr, m_highShift, maxLen, *recorded, false)))
+		recorded->cacheable = true;
+
+	if (!recorded->cacheable)
+	{
+		m_uncacheable++;
+		recorded->exprs.clear();
+		recorded->instructions.clear();
+	}
+	Store(recorded);
+	return result;
+}
+
+
+void LowLevelILLiftCache::Invalidate()
+{
+	for (auto& shard : m_shards)
+	{
+		unique_lock<mutex> lock(shard.mutex);
+		shard.index.clear();
+		shard.entries.clear();
+	}
+}
+
+
+void LowLevelILLiftCache::ResetCounters()
+{
+	m_hits = 0;
+	m_misses = 0;
+	m_uncacheable = 0;
+}
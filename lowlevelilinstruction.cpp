@@ -33,203 +33,56 @@ using namespace BinaryNinja;
 using namespace std;
 
 
-unordered_map<LowLevelILOperandUsage, LowLevelILOperandType>
-	LowLevelILInstructionBase::operandTypeForUsage = {
-		{SourceExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{SourceRegisterLowLevelOperandUsage, RegisterLowLevelOperand},
-		{SourceFlagLowLevelOperandUsage, FlagLowLevelOperand},
-		{SourceSSARegisterLowLevelOperandUsage, SSARegisterLowLevelOperand},
-		{SourceSSAFlagLowLevelOperandUsage, SSAFlagLowLevelOperand},
-		{DestExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{DestRegisterLowLevelOperandUsage, RegisterLowLevelOperand},
-		{DestFlagLowLevelOperandUsage, FlagLowLevelOperand},
-		{DestSSARegisterLowLevelOperandUsage, SSARegisterLowLevelOperand},
-		{DestSSAFlagLowLevelOperandUsage, SSAFlagLowLevelOperand},
-		{PartialRegisterLowLevelOperandUsage, RegisterLowLevelOperand},
-		{StackSSARegisterLowLevelOperandUsage, SSARegisterLowLevelOperand},
-		{StackMemoryVersionLowLevelOperandUsage, IndexLowLevelOperand},
-		{LeftExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{RightExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{CarryExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{HighExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{LowExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{ConditionExprLowLevelOperandUsage, ExprLowLevelOperand},
-		{HighRegisterLowLevelOperandUsage, RegisterLowLevelOperand},
-		{HighSSARegisterLowLevelOperandUsage, SSARegisterLowLevelOperand},
-		{LowRegisterLowLevelOperandUsage, RegisterLowLevelOperand},
-		{LowSSARegisterLowLevelOperandUsage, SSARegisterLowLevelOperand},
-		{ConstantLowLevelOperandUsage, IntegerLowLevelOperand},
-		{VectorLowLevelOperandUsage, IntegerLowLevelOperand},
-		{StackAdjustmentLowLevelOperandUsage, IntegerLowLevelOperand},
-		{TargetLowLevelOperandUsage, IndexLowLevelOperand},
-		{TrueTargetLowLevelOperandUsage, IndexLowLevelOperand},
-		{FalseTargetLowLevelOperandUsage, IndexLowLevelOperand},
-		{BitIndexLowLevelOperandUsage, IndexLowLevelOperand},
-		{SourceMemoryVersionLowLevelOperandUsage, IndexLowLevelOperand},
-		{DestMemoryVersionLowLevelOperandUsage, IndexLowLevelOperand},
-		{FlagConditionLowLevelOperandUsage, FlagConditionLowLevelOperand},
-		{OutputSSARegistersLowLevelOperandUsage, SSARegisterListLowLevelOperand},
-		{OutputMemoryVersionLowLevelOperandUsage, IndexLowLevelOperand},
-		{ParameterSSARegistersLowLevelOperandUsage, SSARegisterListLowLevelOperand},
-		{SourceSSARegistersLowLevelOperandUsage, SSARegisterListLowLevelOperand},
-		{SourceSSAFlagsLowLevelOperandUsage, SSAFlagListLowLevelOperand},
-		{SourceMemoryVersionsLowLevelOperandUsage, IndexListLowLevelOperand},
-		{TargetListLowLevelOperandUsage, IndexListLowLevelOperand}
-	};
+constexpr LowLevelILOperandType LowLevelILOperandTables::operandTypeForUsage[LowLevelILOperandUsageCount];
+constexpr LowLevelILOperationOperandUsages LowLevelILOperandTables::operationOperandUsage[LowLevelILOperationCount];
 
 
-unordered_map<BNLowLevelILOperation, vector<LowLevelILOperandUsage>>
-	LowLevelILInstructionBase::operationOperandUsage = {
-		{LLIL_NOP, {}},
-		{LLIL_POP, {}},
-		{LLIL_NORET, {}},
-		{LLIL_SYSCALL, {}},
-		{LLIL_BP, {}},
-		{LLIL_UNDEF, {}},
-		{LLIL_UNIMPL, {}},
-		{LLIL_SET_REG, {DestRegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_SET_REG_SPLIT, {HighRegisterLowLevelOperandUsage, LowRegisterLowLevelOperandUsage,
-			SourceExprLowLevelOperandUsage}},
-		{LLIL_SET_REG_SSA, {DestSSARegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_SET_REG_SSA_PARTIAL, {DestSSARegisterLowLevelOperandUsage, PartialRegisterLowLevelOperandUsage,
-			SourceExprLowLevelOperandUsage}},
-		{LLIL_SET_REG_SPLIT_SSA, {HighSSARegisterLowLevelOperandUsage,
-			LowSSARegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_SET_FLAG, {DestFlagLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_SET_FLAG_SSA, {DestSSAFlagLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_LOAD, {SourceExprLowLevelOperandUsage}},
-		{LLIL_LOAD_SSA, {SourceExprLowLevelOperandUsage, SourceMemoryVersionLowLevelOperandUsage}},
-		{LLIL_STORE, {DestExprLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_STORE_SSA, {DestExprLowLevelOperandUsage, DestMemoryVersionLowLevelOperandUsage,
-			SourceMemoryVersionLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
-		{LLIL_REG, {SourceRegisterLowLevelOperandUsage}},
-		{LLIL_REG_SSA, {SourceSSARegisterLowLevelOperandUsage}},
-		{LLIL_REG_SSA_PARTIAL, {SourceSSARegisterLowLevelOperandUsage, PartialRegisterLowLevelOperandUsage}},
-		{LLIL_FLAG, {SourceFlagLowLevelOperandUsage}},
-		{LLIL_FLAG_BIT, {SourceFlagLowLevelOperandUsage, BitIndexLowLevelOperandUsage}},
-		{LLIL_FLAG_SSA, {SourceSSAFlagLowLevelOperandUsage}},
-		{LLIL_FLAG_BIT_SSA, {SourceSSAFlagLowLevelOperandUsage, BitIndexLowLevelOperandUsage}},
-		{LLIL_JUMP, {DestExprLowLevelOperandUsage}},
-		{LLIL_JUMP_TO, {DestExprLowLevelOperandUsage, TargetListLowLevelOperandUsage}},
-		{LLIL_CALL, {DestExprLowLevelOperandUsage}},
-		{LLIL_CALL_STACK_ADJUST, {DestExprLowLevelOperandUsage, StackAdjustmentLowLevelOperandUsage}},
-		{LLIL_RET, {DestExprLowLevelOperandUsage}},
-		{LLIL_IF, {ConditionExprLowLevelOperandUsage, TrueTargetLowLevelOperandUsage,
-			FalseTargetLowLevelOperandUsage}},
-		{LLIL_GOTO, {TargetLowLevelOperandUsage}},
-		{LLIL_FLAG_COND, {FlagConditionLowLevelOperandUsage}},
-		{LLIL_TRAP, {VectorLowLevelOperandUsage}},
-		{LLIL_CALL_SSA, {OutputSSARegistersLowLevelOperandUsage, OutputMemoryVersionLowLevelOperandUsage,
-			DestExprLowLevelOperandUsage, StackSSARegisterLowLevelOperandUsage,
-			StackMemoryVersionLowLevelOperandUsage, ParameterSSARegistersLowLevelOperandUsage}},
-		{LLIL_SYSCALL_SSA, {OutputSSARegistersLowLevelOperandUsage, OutputMemoryVersionLowLevelOperandUsage,
-			StackSSARegisterLowLevelOperandUsage, StackMemoryVersionLowLevelOperandUsage,
-			ParameterSSARegistersLowLevelOperandUsage}},
-		{LLIL_REG_PHI, {DestSSARegisterLowLevelOperandUsage, SourceSSARegistersLowLevelOperandUsage}},
-		{LLIL_FLAG_PHI, {DestSSAFlagLowLevelOperandUsage, SourceSSAFlagsLowLevelOperandUsage}},
-		{LLIL_MEM_PHI, {DestMemoryVersionLowLevelOperandUsage, SourceMemoryVersionsLowLevelOperandUsage}},
-		{LLIL_CONST, {ConstantLowLevelOperandUsage}},
-		{LLIL_CONST_PTR, {ConstantLowLevelOperandUsage}},
-		{LLIL_ADD, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_SUB, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_AND, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_OR, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_XOR, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_LSL, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_LSR, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_ASR, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_ROL, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_ROR, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MUL, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MULU_DP, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MULS_DP, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_DIVU, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_DIVS, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MODU, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MODS, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_E, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_NE, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_SLT, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_ULT, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_SLE, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_ULE, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_SGE, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_UGE, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_SGT, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_CMP_UGT, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_TEST_BIT, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_ADD_OVERFLOW, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_ADC, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage, CarryExprLowLevelOperandUsage}},
-		{LLIL_SBB, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage, CarryExprLowLevelOperandUsage}},
-		{LLIL_RLC, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage, CarryExprLowLevelOperandUsage}},
-		{LLIL_RRC, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage, CarryExprLowLevelOperandUsage}},
-		{LLIL_DIVU_DP, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_DIVS_DP, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MODU_DP, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_MODS_DP, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
-		{LLIL_PUSH, {SourceExprLowLevelOperandUsage}},
-		{LLIL_NEG, {SourceExprLowLevelOperandUsage}},
-		{LLIL_NOT, {SourceExprLowLevelOperandUsage}},
-		{LLIL_SX, {SourceExprLowLevelOperandUsage}},
-		{LLIL_ZX, {SourceExprLowLevelOperandUsage}},
-		{LLIL_LOW_PART, {SourceExprLowLevelOperandUsage}},
-		{LLIL_BOOL_TO_INT, {SourceExprLowLevelOperandUsage}},
-		{LLIL_UNIMPL_MEM, {SourceExprLowLevelOperandUsage}}
-	};
+static unordered_map<LowLevelILOperandUsage, LowLevelILOperandType> GetOperandTypeForUsages()
+{
+	unordered_map<LowLevelILOperandUsage, LowLevelILOperandType> result;
+	for (size_t i = 0; i < LowLevelILOperandUsageCount; i++)
+		result[(LowLevelILOperandUsage)i] = LowLevelILOperandTables::operandTypeForUsage[i];
+	return result;
+}
+
+
+static unordered_map<BNLowLevelILOperation, vector<LowLevelILOperandUsage>> GetOperandUsagesForOperations()
+{
+	unordered_map<BNLowLevelILOperation, vector<LowLevelILOperandUsage>> result;
+	for (auto& operation : LowLevelILOperandTables::operationOperandUsage)
+	{
+		if (!operation.valid)
+			continue;
+		result[operation.operation] = vector<LowLevelILOperandUsage>(operation.usages,
+			operation.usages + operation.count);
+	}
+	return result;
+}
 
 
 static unordered_map<BNLowLevelILOperation, unordered_map<LowLevelILOperandUsage, size_t>>
 	GetOperandIndexForOperandUsages()
 {
 	unordered_map<BNLowLevelILOperation, unordered_map<LowLevelILOperandUsage, size_t>> result;
-	for (auto& operation : LowLevelILInstructionBase::operationOperandUsage)
+	for (auto& operation : LowLevelILOperandTables::operationOperandUsage)
 	{
-		result[operation.first] = unordered_map<LowLevelILOperandUsage, size_t>();
-
-		size_t operand = 0;
-		for (auto usage : operation.second)
+		if (!operation.valid)
+			continue;
+		unordered_map<LowLevelILOperandUsage, size_t>& indexMap = result[operation.operation];
+		for (size_t i = 0; i < operation.count; i++)
 		{
-			result[operation.first][usage] = operand;
-			switch (usage)
-			{
-			case HighSSARegisterLowLevelOperandUsage:
-			case LowSSARegisterLowLevelOperandUsage:
-				// Represented as subexpression, so only takes one slot even though it is an SSA register
-				operand++;
-				break;
-			case ParameterSSARegistersLowLevelOperandUsage:
-				// Represented as subexpression, so only takes one slot even though it is a list
-				operand++;
-				break;
-			case OutputSSARegistersLowLevelOperandUsage:
-				// OutputMemoryVersionLowLevelOperandUsage follows at same operand
-				break;
-			case StackSSARegisterLowLevelOperandUsage:
-				// StackMemoryVersionLowLevelOperandUsage follows at same operand
-				break;
-			default:
-				switch (LowLevelILInstructionBase::operandTypeForUsage[usage])
-				{
-				case SSARegisterLowLevelOperand:
-				case SSAFlagLowLevelOperand:
-				case IndexListLowLevelOperand:
-				case SSARegisterListLowLevelOperand:
-				case SSAFlagListLowLevelOperand:
-					// SSA registers/flags and lists take two operand slots
-					operand += 2;
-					break;
-				default:
-					operand++;
-					break;
-				}
-				break;
-			}
+			indexMap[operation.usages[i]] = (size_t)GetLowLevelILOperandIndex(operation.operation,
+				operation.usages[i]);
 		}
 	}
 	return result;
 }
 
 
+unordered_map<LowLevelILOperandUsage, LowLevelILOperandType>
+	LowLevelILInstructionBase::operandTypeForUsage = GetOperandTypeForUsages();
+unordered_map<BNLowLevelILOperation, vector<LowLevelILOperandUsage>>
+	LowLevelILInstructionBase::operationOperandUsage = GetOperandUsagesForOperations();
 unordered_map<BNLowLevelILOperation, unordered_map<LowLevelILOperandUsage, size_t>>
 	LowLevelILInstructionBase::operationOperandIndex = GetOperandIndexForOperandUsages();
 
@@ -606,10 +459,9 @@ LowLevelILOperand::LowLevelILOperand(const LowLevelILInstruction& instr,
 	LowLevelILOperandUsage usage, size_t operandIndex):
 	m_instr(instr), m_usage(usage), m_operandIndex(operandIndex)
 {
-	auto i = LowLevelILInstructionBase::operandTypeForUsage.find(m_usage);
-	if (i == LowLevelILInstructionBase::operandTypeForUsage.end())
+	if ((size_t)m_usage >= LowLevelILOperandUsageCount)
 		throw LowLevelILInstructionAccessException();
-	m_type = i->second;
+	m_type = GetLowLevelILOperandType(m_usage);
 }
 
 
@@ -715,17 +567,15 @@ LowLevelILSSAFlagList LowLevelILOperand::GetSSAFlagList() const
 const LowLevelILOperand LowLevelILOperandList::ListIterator::operator*()
 {
 	LowLevelILOperandUsage usage = *pos;
-	auto i = owner->m_operandIndexMap.find(usage);
-	if (i == owner->m_operandIndexMap.end())
+	int operandIndex = GetLowLevelILOperandIndex(owner->m_instr.operation, usage);
+	if (operandIndex < 0)
 		throw LowLevelILInstructionAccessException();
-	return LowLevelILOperand(owner->m_instr, usage, i->second);
+	return LowLevelILOperand(owner->m_instr, usage, (size_t)operandIndex);
 }
 
 
 LowLevelILOperandList::LowLevelILOperandList(const LowLevelILInstruction& instr,
-	const vector<LowLevelILOperandUsage>& usageList,
-	const unordered_map<LowLevelILOperandUsage, size_t>& operandIndexMap):
-	m_instr(instr), m_usageList(usageList), m_operandIndexMap(operandIndexMap)
+	const LowLevelILOperationOperandUsages& usageList): m_instr(instr), m_usageList(usageList)
 {
 }
 
@@ -734,7 +584,7 @@ LowLevelILOperandList::const_iterator LowLevelILOperandList::begin() const
 {
 	const_iterator result;
 	result.owner = this;
-	result.pos = m_usageList.begin();
+	result.pos = m_usageList.usages;
 	return result;
 }
 
@@ -743,24 +593,26 @@ LowLevelILOperandList::const_iterator LowLevelILOperandList::end() const
 {
 	const_iterator result;
 	result.owner = this;
-	result.pos = m_usageList.end();
+	result.pos = m_usageList.usages + m_usageList.count;
 	return result;
 }
 
 
 size_t LowLevelILOperandList::size() const
 {
-	return m_usageList.size();
+	return m_usageList.count;
 }
 
 
 const LowLevelILOperand LowLevelILOperandList::operator[](size_t i) const
 {
-	LowLevelILOperandUsage usage = m_usageList[i];
-	auto indexMap = m_operandIndexMap.find(usage);
-	if (indexMap == m_operandIndexMap.end())
+	if (i >= m_usageList.count)
+		throw LowLevelILInstructionAccessException();
+	LowLevelILOperandUsage usage = m_usageList.usages[i];
+	int operandIndex = GetLowLevelILOperandIndex(m_instr.operation, usage);
+	if (operandIndex < 0)
 		throw LowLevelILInstructionAccessException();
-	return LowLevelILOperand(m_instr, usage, indexMap->second);
+	return LowLevelILOperand(m_instr, usage, (size_t)operandIndex);
 }
 
 
@@ -823,13 +675,10 @@ LowLevelILInstruction::LowLevelILInstruction(const LowLevelILInstructionBase& in
 
 LowLevelILOperandList LowLevelILInstructionBase::GetOperands() const
 {
-	auto usage = operationOperandUsage.find(operation);
-	if (usage == operationOperandUsage.end())
-		throw LowLevelILInstructionAccessException();
-	auto operandIndex = operationOperandIndex.find(operation);
-	if (operandIndex == operationOperandIndex.end())
+	if (!IsLowLevelILOperationValidForOperands(operation))
 		throw LowLevelILInstructionAccessException();
-	return LowLevelILOperandList(*(const LowLevelILInstruction*)this, usage->second, operandIndex->second);
+	return LowLevelILOperandList(*(const LowLevelILInstruction*)this,
+		LowLevelILOperandTables::operationOperandUsage[operation]);
 }
 
 
@@ -1111,65 +960,70 @@ void LowLevelILInstructionBase::Replace(ExprId expr)
 
 void LowLevelILInstruction::VisitExprs(const std::function<bool(const LowLevelILInstruction& expr)>& func) const
 {
-	if (!func(*this))
-		return;
+	VisitExprTree(func);
+}
+
+
+void LowLevelILInstruction::GetSubExprs(vector<LowLevelILInstruction>& exprs) const
+{
+	exprs.clear();
 	switch (operation)
 	{
 	case LLIL_SET_REG:
-		GetSourceExpr<LLIL_SET_REG>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_REG>());
 		break;
 	case LLIL_SET_REG_SPLIT:
-		GetSourceExpr<LLIL_SET_REG_SPLIT>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_REG_SPLIT>());
 		break;
 	case LLIL_SET_REG_SSA:
-		GetSourceExpr<LLIL_SET_REG_SSA>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_REG_SSA>());
 		break;
 	case LLIL_SET_REG_SSA_PARTIAL:
-		GetSourceExpr<LLIL_SET_REG_SSA_PARTIAL>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_REG_SSA_PARTIAL>());
 		break;
 	case LLIL_SET_REG_SPLIT_SSA:
-		GetSourceExpr<LLIL_SET_REG_SPLIT_SSA>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_REG_SPLIT_SSA>());
 		break;
 	case LLIL_SET_FLAG:
-		GetSourceExpr<LLIL_SET_FLAG>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_FLAG>());
 		break;
 	case LLIL_SET_FLAG_SSA:
-		GetSourceExpr<LLIL_SET_FLAG_SSA>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_SET_FLAG_SSA>());
 		break;
 	case LLIL_LOAD:
-		GetSourceExpr<LLIL_LOAD>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_LOAD>());
 		break;
 	case LLIL_LOAD_SSA:
-		GetSourceExpr<LLIL_LOAD_SSA>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<LLIL_LOAD_SSA>());
 		break;
 	case LLIL_STORE:
-		GetDestExpr<LLIL_STORE>().VisitExprs(func);
-		GetSourceExpr<LLIL_STORE>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_STORE>());
+		exprs.push_back(GetSourceExpr<LLIL_STORE>());
 		break;
 	case LLIL_STORE_SSA:
-		GetDestExpr<LLIL_STORE_SSA>().VisitExprs(func);
-		GetSourceExpr<LLIL_STORE_SSA>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_STORE_SSA>());
+		exprs.push_back(GetSourceExpr<LLIL_STORE_SSA>());
 		break;
 	case LLIL_JUMP:
-		GetDestExpr<LLIL_JUMP>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_JUMP>());
 		break;
 	case LLIL_JUMP_TO:
-		GetDestExpr<LLIL_JUMP_TO>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_JUMP_TO>());
 		break;
 	case LLIL_IF:
-		GetConditionExpr<LLIL_IF>().VisitExprs(func);
+		exprs.push_back(GetConditionExpr<LLIL_IF>());
 		break;
 	case LLIL_CALL:
-		GetDestExpr<LLIL_CALL>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_CALL>());
 		break;
 	case LLIL_CALL_STACK_ADJUST:
-		GetDestExpr<LLIL_CALL_STACK_ADJUST>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_CALL_STACK_ADJUST>());
 		break;
 	case LLIL_CALL_SSA:
-		GetDestExpr<LLIL_CALL_SSA>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_CALL_SSA>());
 		break;
 	case LLIL_RET:
-		GetDestExpr<LLIL_RET>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<LLIL_RET>());
 		break;
 	case LLIL_PUSH:
 	case LLIL_NEG:
@@ -1179,7 +1033,7 @@ void LowLevelILInstruction::VisitExprs(const std::function<bool(const LowLevelIL
 	case LLIL_LOW_PART:
 	case LLIL_BOOL_TO_INT:
 	case LLIL_UNIMPL_MEM:
-		AsOneOperand().GetSourceExpr().VisitExprs(func);
+		exprs.push_back(AsOneOperand().GetSourceExpr());
 		break;
 	case LLIL_ADD:
 	case LLIL_SUB:
@@ -1210,24 +1064,24 @@ void LowLevelILInstruction::VisitExprs(const std::function<bool(const LowLevelIL
 	case LLIL_CMP_UGT:
 	case LLIL_TEST_BIT:
 	case LLIL_ADD_OVERFLOW:
-		AsTwoOperand().GetLeftExpr().VisitExprs(func);
-		AsTwoOperand().GetRightExpr().VisitExprs(func);
+		exprs.push_back(AsTwoOperand().GetLeftExpr());
+		exprs.push_back(AsTwoOperand().GetRightExpr());
 		break;
 	case LLIL_ADC:
 	case LLIL_SBB:
 	case LLIL_RLC:
 	case LLIL_RRC:
-		AsTwoOperandWithCarry().GetLeftExpr().VisitExprs(func);
-		AsTwoOperandWithCarry().GetRightExpr().VisitExprs(func);
-		AsTwoOperandWithCarry().GetCarryExpr().VisitExprs(func);
+		exprs.push_back(AsTwoOperandWithCarry().GetLeftExpr());
+		exprs.push_back(AsTwoOperandWithCarry().GetRightExpr());
+		exprs.push_back(AsTwoOperandWithCarry().GetCarryExpr());
 		break;
 	case LLIL_DIVU_DP:
 	case LLIL_DIVS_DP:
 	case LLIL_MODU_DP:
 	case LLIL_MODS_DP:
-		AsDoublePrecision().GetHighExpr().VisitExprs(func);
-		AsDoublePrecision().GetLowExpr().VisitExprs(func);
-		AsDoublePrecision().GetRightExpr().VisitExprs(func);
+		exprs.push_back(AsDoublePrecision().GetHighExpr());
+		exprs.push_back(AsDoublePrecision().GetLowExpr());
+		exprs.push_back(AsDoublePrecision().GetRightExpr());
 		break;
 	default:
 		break;
@@ -1428,13 +1282,10 @@ ExprId LowLevelILInstruction::CopyTo(LowLevelILFunction* dest,
 
 bool LowLevelILInstruction::GetOperandIndexForUsage(LowLevelILOperandUsage usage, size_t& operandIndex) const
 {
-	auto operationIter = LowLevelILInstructionBase::operationOperandIndex.find(operation);
-	if (operationIter == LowLevelILInstructionBase::operationOperandIndex.end())
-		return false;
-	auto usageIter = operationIter->second.find(usage);
-	if (usageIter == operationIter->second.end())
+	int index = GetLowLevelILOperandIndex(operation, usage);
+	if (index < 0)
 		return false;
-	operandIndex = usageIter->second;
+	operandIndex = (size_t)index;
 	return true;
 }
 
@@ -218,6 +218,264 @@ namespace BinaryNinjaCore
 namespace BinaryNinja
 #endif
 {
+	// Dense operand metadata tables. These are indexed directly by operation and operand usage, and can be
+	// used from constexpr context. When adding an operation or operand usage, the counts below must be kept
+	// in sync with the enumerations.
+	constexpr size_t LowLevelILOperationCount = LLIL_MEM_PHI + 1;
+	constexpr size_t LowLevelILOperandUsageCount = TargetListLowLevelOperandUsage + 1;
+	constexpr size_t LowLevelILMaxOperandUsages = 6;
+
+	struct LowLevelILOperationOperandUsages
+	{
+		BNLowLevelILOperation operation;
+		bool valid;
+		size_t count;
+		LowLevelILOperandUsage usages[LowLevelILMaxOperandUsages];
+	};
+
+	struct LowLevelILOperandIndexRow
+	{
+		int8_t index[LowLevelILOperandUsageCount];
+	};
+
+	template <size_t... N> struct LowLevelILIndexSequence {};
+	template <size_t N, size_t... S> struct LowLevelILMakeIndexSequence:
+		LowLevelILMakeIndexSequence<N - 1, N - 1, S...> {};
+	template <size_t... S> struct LowLevelILMakeIndexSequence<0, S...>
+	{
+		typedef LowLevelILIndexSequence<S...> Type;
+	};
+
+	struct LowLevelILOperandTables
+	{
+		static constexpr LowLevelILOperandType operandTypeForUsage[LowLevelILOperandUsageCount] = {
+			ExprLowLevelOperand, // SourceExprLowLevelOperandUsage
+			RegisterLowLevelOperand, // SourceRegisterLowLevelOperandUsage
+			FlagLowLevelOperand, // SourceFlagLowLevelOperandUsage
+			SSARegisterLowLevelOperand, // SourceSSARegisterLowLevelOperandUsage
+			SSAFlagLowLevelOperand, // SourceSSAFlagLowLevelOperandUsage
+			ExprLowLevelOperand, // DestExprLowLevelOperandUsage
+			RegisterLowLevelOperand, // DestRegisterLowLevelOperandUsage
+			FlagLowLevelOperand, // DestFlagLowLevelOperandUsage
+			SSARegisterLowLevelOperand, // DestSSARegisterLowLevelOperandUsage
+			SSAFlagLowLevelOperand, // DestSSAFlagLowLevelOperandUsage
+			RegisterLowLevelOperand, // PartialRegisterLowLevelOperandUsage
+			SSARegisterLowLevelOperand, // StackSSARegisterLowLevelOperandUsage
+			IndexLowLevelOperand, // StackMemoryVersionLowLevelOperandUsage
+			ExprLowLevelOperand, // LeftExprLowLevelOperandUsage
+			ExprLowLevelOperand, // RightExprLowLevelOperandUsage
+			ExprLowLevelOperand, // CarryExprLowLevelOperandUsage
+			ExprLowLevelOperand, // HighExprLowLevelOperandUsage
+			ExprLowLevelOperand, // LowExprLowLevelOperandUsage
+			ExprLowLevelOperand, // ConditionExprLowLevelOperandUsage
+			RegisterLowLevelOperand, // HighRegisterLowLevelOperandUsage
+			SSARegisterLowLevelOperand, // HighSSARegisterLowLevelOperandUsage
+			RegisterLowLevelOperand, // LowRegisterLowLevelOperandUsage
+			SSARegisterLowLevelOperand, // LowSSARegisterLowLevelOperandUsage
+			IntegerLowLevelOperand, // ConstantLowLevelOperandUsage
+			IntegerLowLevelOperand, // VectorLowLevelOperandUsage
+			IntegerLowLevelOperand, // StackAdjustmentLowLevelOperandUsage
+			IndexLowLevelOperand, // TargetLowLevelOperandUsage
+			IndexLowLevelOperand, // TrueTargetLowLevelOperandUsage
+			IndexLowLevelOperand, // FalseTargetLowLevelOperandUsage
+			IndexLowLevelOperand, // BitIndexLowLevelOperandUsage
+			IndexLowLevelOperand, // SourceMemoryVersionLowLevelOperandUsage
+			IndexLowLevelOperand, // DestMemoryVersionLowLevelOperandUsage
+			FlagConditionLowLevelOperand, // FlagConditionLowLevelOperandUsage
+			SSARegisterListLowLevelOperand, // OutputSSARegistersLowLevelOperandUsage
+			IndexLowLevelOperand, // OutputMemoryVersionLowLevelOperandUsage
+			SSARegisterListLowLevelOperand, // ParameterSSARegistersLowLevelOperandUsage
+			SSARegisterListLowLevelOperand, // SourceSSARegistersLowLevelOperandUsage
+			SSAFlagListLowLevelOperand, // SourceSSAFlagsLowLevelOperandUsage
+			IndexListLowLevelOperand, // SourceMemoryVersionsLowLevelOperandUsage
+			IndexListLowLevelOperand // TargetListLowLevelOperandUsage
+		};
+
+		// Ordered by operation, operations without an entry are not valid for operand access
+		static constexpr LowLevelILOperationOperandUsages operationOperandUsage[LowLevelILOperationCount] = {
+			{LLIL_NOP, true, 0, {}},
+			{LLIL_SET_REG, true, 2, {DestRegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_SET_REG_SPLIT, true, 3, {HighRegisterLowLevelOperandUsage, LowRegisterLowLevelOperandUsage,
+				SourceExprLowLevelOperandUsage}},
+			{LLIL_SET_FLAG, true, 2, {DestFlagLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_LOAD, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_STORE, true, 2, {DestExprLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_PUSH, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_POP, true, 0, {}},
+			{LLIL_REG, true, 1, {SourceRegisterLowLevelOperandUsage}},
+			{LLIL_CONST, true, 1, {ConstantLowLevelOperandUsage}},
+			{LLIL_CONST_PTR, true, 1, {ConstantLowLevelOperandUsage}},
+			{LLIL_FLAG, true, 1, {SourceFlagLowLevelOperandUsage}},
+			{LLIL_FLAG_BIT, true, 2, {SourceFlagLowLevelOperandUsage, BitIndexLowLevelOperandUsage}},
+			{LLIL_ADD, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_ADC, true, 3, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage,
+				CarryExprLowLevelOperandUsage}},
+			{LLIL_SUB, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_SBB, true, 3, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage,
+				CarryExprLowLevelOperandUsage}},
+			{LLIL_AND, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_OR, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_XOR, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_LSL, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_LSR, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_ASR, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_ROL, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_RLC, true, 3, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage,
+				CarryExprLowLevelOperandUsage}},
+			{LLIL_ROR, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_RRC, true, 3, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage,
+				CarryExprLowLevelOperandUsage}},
+			{LLIL_MUL, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_MULU_DP, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_MULS_DP, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_DIVU, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_DIVU_DP, true, 3, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage,
+				RightExprLowLevelOperandUsage}},
+			{LLIL_DIVS, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_DIVS_DP, true, 3, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage,
+				RightExprLowLevelOperandUsage}},
+			{LLIL_MODU, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_MODU_DP, true, 3, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage,
+				RightExprLowLevelOperandUsage}},
+			{LLIL_MODS, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_MODS_DP, true, 3, {HighExprLowLevelOperandUsage, LowExprLowLevelOperandUsage,
+				RightExprLowLevelOperandUsage}},
+			{LLIL_NEG, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_NOT, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_SX, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_ZX, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_LOW_PART, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_JUMP, true, 1, {DestExprLowLevelOperandUsage}},
+			{LLIL_JUMP_TO, true, 2, {DestExprLowLevelOperandUsage, TargetListLowLevelOperandUsage}},
+			{LLIL_CALL, true, 1, {DestExprLowLevelOperandUsage}},
+			{LLIL_CALL_STACK_ADJUST, true, 2, {DestExprLowLevelOperandUsage, StackAdjustmentLowLevelOperandUsage}},
+			{LLIL_RET, true, 1, {DestExprLowLevelOperandUsage}},
+			{LLIL_NORET, true, 0, {}},
+			{LLIL_IF, true, 3, {ConditionExprLowLevelOperandUsage, TrueTargetLowLevelOperandUsage,
+				FalseTargetLowLevelOperandUsage}},
+			{LLIL_GOTO, true, 1, {TargetLowLevelOperandUsage}},
+			{LLIL_FLAG_COND, true, 1, {FlagConditionLowLevelOperandUsage}},
+			{LLIL_CMP_E, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_NE, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_SLT, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_ULT, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_SLE, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_ULE, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_SGE, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_UGE, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_SGT, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_CMP_UGT, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_TEST_BIT, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_BOOL_TO_INT, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_ADD_OVERFLOW, true, 2, {LeftExprLowLevelOperandUsage, RightExprLowLevelOperandUsage}},
+			{LLIL_SYSCALL, true, 0, {}},
+			{LLIL_BP, true, 0, {}},
+			{LLIL_TRAP, true, 1, {VectorLowLevelOperandUsage}},
+			{LLIL_UNDEF, true, 0, {}},
+			{LLIL_UNIMPL, true, 0, {}},
+			{LLIL_UNIMPL_MEM, true, 1, {SourceExprLowLevelOperandUsage}},
+			{LLIL_SET_REG_SSA, true, 2, {DestSSARegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_SET_REG_SSA_PARTIAL, true, 3, {DestSSARegisterLowLevelOperandUsage,
+				PartialRegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_SET_REG_SPLIT_SSA, true, 3, {HighSSARegisterLowLevelOperandUsage,
+				LowSSARegisterLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_REG_SPLIT_DEST_SSA, false, 0, {}},
+			{LLIL_REG_SSA, true, 1, {SourceSSARegisterLowLevelOperandUsage}},
+			{LLIL_REG_SSA_PARTIAL, true, 2, {SourceSSARegisterLowLevelOperandUsage,
+				PartialRegisterLowLevelOperandUsage}},
+			{LLIL_SET_FLAG_SSA, true, 2, {DestSSAFlagLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_FLAG_SSA, true, 1, {SourceSSAFlagLowLevelOperandUsage}},
+			{LLIL_FLAG_BIT_SSA, true, 2, {SourceSSAFlagLowLevelOperandUsage, BitIndexLowLevelOperandUsage}},
+			{LLIL_CALL_SSA, true, 6, {OutputSSARegistersLowLevelOperandUsage,
+				OutputMemoryVersionLowLevelOperandUsage, DestExprLowLevelOperandUsage,
+				StackSSARegisterLowLevelOperandUsage, StackMemoryVersionLowLevelOperandUsage,
+				ParameterSSARegistersLowLevelOperandUsage}},
+			{LLIL_SYSCALL_SSA, true, 5, {OutputSSARegistersLowLevelOperandUsage,
+				OutputMemoryVersionLowLevelOperandUsage, StackSSARegisterLowLevelOperandUsage,
+				StackMemoryVersionLowLevelOperandUsage, ParameterSSARegistersLowLevelOperandUsage}},
+			{LLIL_CALL_PARAM_SSA, false, 0, {}},
+			{LLIL_CALL_STACK_SSA, false, 0, {}},
+			{LLIL_CALL_OUTPUT_SSA, false, 0, {}},
+			{LLIL_LOAD_SSA, true, 2, {SourceExprLowLevelOperandUsage, SourceMemoryVersionLowLevelOperandUsage}},
+			{LLIL_STORE_SSA, true, 4, {DestExprLowLevelOperandUsage, DestMemoryVersionLowLevelOperandUsage,
+				SourceMemoryVersionLowLevelOperandUsage, SourceExprLowLevelOperandUsage}},
+			{LLIL_REG_PHI, true, 2, {DestSSARegisterLowLevelOperandUsage, SourceSSARegistersLowLevelOperandUsage}},
+			{LLIL_FLAG_PHI, true, 2, {DestSSAFlagLowLevelOperandUsage, SourceSSAFlagsLowLevelOperandUsage}},
+			{LLIL_MEM_PHI, true, 2, {DestMemoryVersionLowLevelOperandUsage,
+				SourceMemoryVersionsLowLevelOperandUsage}}
+		};
+
+		static constexpr bool IsOrdered(size_t i = 0)
+		{
+			return (i >= LowLevelILOperationCount) ||
+				(((size_t)operationOperandUsage[i].operation == i) && IsOrdered(i + 1));
+		}
+
+		static constexpr size_t GetOperandSlotCount(LowLevelILOperandUsage usage)
+		{
+			// SSA registers/flags and lists take two operand slots, except for those represented as a
+			// subexpression, which take one, and those followed by a memory version at the same operand
+			return ((usage == HighSSARegisterLowLevelOperandUsage) || (usage == LowSSARegisterLowLevelOperandUsage) ||
+				(usage == ParameterSSARegistersLowLevelOperandUsage)) ? 1 :
+				((usage == OutputSSARegistersLowLevelOperandUsage) || (usage == StackSSARegisterLowLevelOperandUsage)) ? 0 :
+				((operandTypeForUsage[usage] == SSARegisterLowLevelOperand) ||
+				(operandTypeForUsage[usage] == SSAFlagLowLevelOperand) ||
+				(operandTypeForUsage[usage] == IndexListLowLevelOperand) ||
+				(operandTypeForUsage[usage] == SSARegisterListLowLevelOperand) ||
+				(operandTypeForUsage[usage] == SSAFlagListLowLevelOperand)) ? 2 : 1;
+		}
+
+		static constexpr int8_t ComputeOperandIndex(const LowLevelILOperationOperandUsages& operation,
+			LowLevelILOperandUsage usage, size_t i = 0, size_t slot = 0)
+		{
+			return (i >= operation.count) ? -1 : (operation.usages[i] == usage) ? (int8_t)slot :
+				ComputeOperandIndex(operation, usage, i + 1, slot + GetOperandSlotCount(operation.usages[i]));
+		}
+
+		template <size_t... Usage>
+		static constexpr LowLevelILOperandIndexRow ComputeOperandIndexRow(size_t operation,
+			LowLevelILIndexSequence<Usage...>)
+		{
+			return LowLevelILOperandIndexRow{{ComputeOperandIndex(operationOperandUsage[operation],
+				(LowLevelILOperandUsage)Usage)...}};
+		}
+	};
+
+	static_assert(LowLevelILOperandTables::IsOrdered(), "LLIL operand usage table must be ordered by operation");
+
+	template <typename Operations> struct LowLevelILOperandIndexTable;
+	template <size_t... Operation> struct LowLevelILOperandIndexTable<LowLevelILIndexSequence<Operation...>>
+	{
+		static constexpr LowLevelILOperandIndexRow rows[sizeof...(Operation)] = {
+			LowLevelILOperandTables::ComputeOperandIndexRow(Operation,
+				LowLevelILMakeIndexSequence<LowLevelILOperandUsageCount>::Type())...
+		};
+	};
+
+	template <size_t... Operation> constexpr LowLevelILOperandIndexRow
+		LowLevelILOperandIndexTable<LowLevelILIndexSequence<Operation...>>::rows[sizeof...(Operation)];
+
+	typedef LowLevelILOperandIndexTable<LowLevelILMakeIndexSequence<LowLevelILOperationCount>::Type>
+		LowLevelILOperandIndices;
+
+	constexpr bool IsLowLevelILOperationValidForOperands(BNLowLevelILOperation operation)
+	{
+		return ((size_t)operation < LowLevelILOperationCount) &&
+			LowLevelILOperandTables::operationOperandUsage[operation].valid;
+	}
+
+	constexpr LowLevelILOperandType GetLowLevelILOperandType(LowLevelILOperandUsage usage)
+	{
+		return LowLevelILOperandTables::operandTypeForUsage[usage];
+	}
+
+	// Returns the operand index for the given usage, or -1 if the operation does not have that operand
+	constexpr int GetLowLevelILOperandIndex(BNLowLevelILOperation operation, LowLevelILOperandUsage usage)
+	{
+		return (((size_t)operation < LowLevelILOperationCount) && ((size_t)usage < LowLevelILOperandUsageCount)) ?
+			LowLevelILOperandIndices::rows[operation].index[usage] : -1;
+	}
+
 	class LowLevelILInstructionAccessException: public std::exception
 	{
 	public:
@@ -471,6 +729,15 @@ namespace BinaryNinja
 
 		void VisitExprs(const std::function<bool(const LowLevelILInstruction& expr)>& func) const;
 
+		// Walks the expression tree with an explicit stack instead of recursion, so arbitrarily deep expressions
+		// can be visited. The pre-order callback returns false to skip the subexpressions of the expression
+		// it was given; the post-order callback is called once all subexpressions have been visited and is not
+		// called for skipped expressions.
+		template <typename PreFunc> void VisitExprTree(const PreFunc& preOrder) const;
+		template <typename PreFunc, typename PostFunc>
+		void VisitExprTree(const PreFunc& preOrder, const PostFunc& postOrder) const;
+		void GetSubExprs(std::vector<LowLevelILInstruction>& exprs) const;
+
 		ExprId CopyTo(LowLevelILFunction* dest) const;
 		ExprId CopyTo(LowLevelILFunction* dest,
 			const std::function<ExprId(const LowLevelILInstruction& subExpr)>& subExprHandler) const;
@@ -601,7 +868,7 @@ namespace BinaryNinja
 		struct ListIterator
 		{
 			const LowLevelILOperandList* owner;
-			std::vector<LowLevelILOperandUsage>::const_iterator pos;
+			const LowLevelILOperandUsage* pos;
 			bool operator==(const ListIterator& a) const { return pos == a.pos; }
 			bool operator!=(const ListIterator& a) const { return pos != a.pos; }
 			bool operator<(const ListIterator& a) const { return pos < a.pos; }
@@ -610,15 +877,12 @@ namespace BinaryNinja
 		};
 
 		LowLevelILInstruction m_instr;
-		const std::vector<LowLevelILOperandUsage>& m_usageList;
-		const std::unordered_map<LowLevelILOperandUsage, size_t>& m_operandIndexMap;
+		const LowLevelILOperationOperandUsages& m_usageList;
 
 	public:
 		typedef ListIterator const_iterator;
 
-		LowLevelILOperandList(const LowLevelILInstruction& instr,
-			const std::vector<LowLevelILOperandUsage>& usageList,
-			const std::unordered_map<LowLevelILOperandUsage, size_t>& operandIndexMap);
+		LowLevelILOperandList(const LowLevelILInstruction& instr, const LowLevelILOperationOperandUsages& usageList);
 
 		const_iterator begin() const;
 		const_iterator end() const;
@@ -911,4 +1175,40 @@ namespace BinaryNinja
 	template <> struct LowLevelILInstructionAccessor<LLIL_LOW_PART>: public LowLevelILOneOperandInstruction {};
 	template <> struct LowLevelILInstructionAccessor<LLIL_BOOL_TO_INT>: public LowLevelILOneOperandInstruction {};
 	template <> struct LowLevelILInstructionAccessor<LLIL_UNIMPL_MEM>: public LowLevelILOneOperandInstruction {};
+
+	template <typename PreFunc>
+	void LowLevelILInstruction::VisitExprTree(const PreFunc& preOrder) const
+	{
+		VisitExprTree(preOrder, [](const LowLevelILInstruction&) {});
+	}
+
+	template <typename PreFunc, typename PostFunc>
+	void LowLevelILInstruction::VisitExprTree(const PreFunc& preOrder, const PostFunc& postOrder) const
+	{
+		// Each stack entry holds an expression and whether its subexpressions have already been pushed
+		std::vector<std::pair<LowLevelILInstruction, bool>> stack;
+		std::vector<LowLevelILInstruction> subExprs;
+		stack.push_back(std::make_pair(*this, false));
+		while (!stack.empty())
+		{
+			if (stack.back().second)
+			{
+				postOrder(stack.back().first);
+				stack.pop_back();
+				continue;
+			}
+
+			if (!preOrder(stack.back().first))
+			{
+				stack.pop_back();
+				continue;
+			}
+
+			stack.back().second = true;
+			stack.back().first.GetSubExprs(subExprs);
+			// Move the subexpressions onto the stack so that visiting does not take extra function references
+			for (auto i = subExprs.rbegin(); i != subExprs.rend(); ++i)
+				stack.emplace_back(std::move(*i), false);
+		}
+	}
 }
@@ -337,20 +337,7 @@ bool MediumLevelILFunction::GetExprText(Architecture* arch, ExprId expr, vector<
 	if (!BNGetMediumLevelILExprText(m_object, arch->GetObject(), expr, &list, &count))
 		return false;
 
-	tokens.clear();
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = list[i].type;
-		token.text = list[i].text;
-		token.value = list[i].value;
-		token.size = list[i].size;
-		token.operand = list[i].operand;
-		token.context = list[i].context;
-		token.confidence = list[i].confidence;
-		token.address = list[i].address;
-		tokens.push_back(token);
-	}
+	tokens = InstructionTextToken::ConvertInstructionTextTokenList(list, count);
 
 	BNFreeInstructionText(list, count);
 	return true;
@@ -366,20 +353,7 @@ bool MediumLevelILFunction::GetInstructionText(Function* func, Architecture* arc
 		instr, &list, &count))
 		return false;
 
-	tokens.clear();
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = list[i].type;
-		token.text = list[i].text;
-		token.value = list[i].value;
-		token.size = list[i].size;
-		token.operand = list[i].operand;
-		token.context = list[i].context;
-		token.confidence = list[i].confidence;
-		token.address = list[i].address;
-		tokens.push_back(token);
-	}
+	tokens = InstructionTextToken::ConvertInstructionTextTokenList(list, count);
 
 	BNFreeInstructionText(list, count);
 	return true;
@@ -412,8 +386,9 @@ vector<Ref<BasicBlock>> MediumLevelILFunction::GetBasicBlocks() const
 	BNBasicBlock** blocks = BNGetMediumLevelILBasicBlockList(m_object, &count);
 
 	vector<Ref<BasicBlock>> result;
+	result.reserve(count);
 	for (size_t i = 0; i < count; i++)
-		result.push_back(new BasicBlock(BNNewBasicBlockReference(blocks[i])));
+		result.push_back(Ref<BasicBlock>::Adopt(new BasicBlock(BNNewBasicBlockReference(blocks[i]))));
 
 	BNFreeBasicBlockList(blocks, count);
 	return result;
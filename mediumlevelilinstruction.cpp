@@ -33,231 +33,56 @@ using namespace BinaryNinja;
 using namespace std;
 
 
-unordered_map<MediumLevelILOperandUsage, MediumLevelILOperandType>
-	MediumLevelILInstructionBase::operandTypeForUsage = {
-		{SourceExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{SourceVariableMediumLevelOperandUsage, VariableMediumLevelOperand},
-		{SourceSSAVariableMediumLevelOperandUsage, SSAVariableMediumLevelOperand},
-		{PartialSSAVariableSourceMediumLevelOperandUsage, SSAVariableMediumLevelOperand},
-		{DestExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{DestVariableMediumLevelOperandUsage, VariableMediumLevelOperand},
-		{DestSSAVariableMediumLevelOperandUsage, SSAVariableMediumLevelOperand},
-		{LeftExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{RightExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{CarryExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{HighExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{LowExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{StackExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{ConditionExprMediumLevelOperandUsage, ExprMediumLevelOperand},
-		{HighVariableMediumLevelOperandUsage, VariableMediumLevelOperand},
-		{LowVariableMediumLevelOperandUsage, VariableMediumLevelOperand},
-		{HighSSAVariableMediumLevelOperandUsage, VariableMediumLevelOperand},
-		{LowSSAVariableMediumLevelOperandUsage, VariableMediumLevelOperand},
-		{OffsetMediumLevelOperandUsage, IntegerMediumLevelOperand},
-		{ConstantMediumLevelOperandUsage, IntegerMediumLevelOperand},
-		{VectorMediumLevelOperandUsage, IntegerMediumLevelOperand},
-		{TargetMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{TrueTargetMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{FalseTargetMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{DestMemoryVersionMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{SourceMemoryVersionMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{TargetListMediumLevelOperandUsage, IndexListMediumLevelOperand},
-		{SourceMemoryVersionsMediumLevelOperandUsage, IndexListMediumLevelOperand},
-		{OutputVariablesMediumLevelOperandUsage, VariableListMediumLevelOperand},
-		{OutputVariablesSubExprMediumLevelOperandUsage, VariableListMediumLevelOperand},
-		{OutputSSAVariablesMediumLevelOperandUsage, SSAVariableListMediumLevelOperand},
-		{OutputSSAMemoryVersionMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{ParameterExprsMediumLevelOperandUsage, ExprListMediumLevelOperand},
-		{SourceExprsMediumLevelOperandUsage, ExprListMediumLevelOperand},
-		{ParameterVariablesMediumLevelOperandUsage, VariableListMediumLevelOperand},
-		{ParameterSSAVariablesMediumLevelOperandUsage, SSAVariableListMediumLevelOperand},
-		{ParameterSSAMemoryVersionMediumLevelOperandUsage, IndexMediumLevelOperand},
-		{SourceSSAVariablesMediumLevelOperandUsages, SSAVariableListMediumLevelOperand}
-	};
+constexpr MediumLevelILOperandType MediumLevelILOperandTables::operandTypeForUsage[MediumLevelILOperandUsageCount];
+constexpr MediumLevelILOperationOperandUsages MediumLevelILOperandTables::operationOperandUsage[MediumLevelILOperationCount];
 
 
-unordered_map<BNMediumLevelILOperation, vector<MediumLevelILOperandUsage>>
-	MediumLevelILInstructionBase::operationOperandUsage = {
-		{MLIL_NOP, {}},
-		{MLIL_NORET, {}},
-		{MLIL_BP, {}},
-		{MLIL_UNDEF, {}},
-		{MLIL_UNIMPL, {}},
-		{MLIL_SET_VAR, {DestVariableMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_FIELD, {DestVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
-			SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_SPLIT, {HighVariableMediumLevelOperandUsage, LowVariableMediumLevelOperandUsage,
-			SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_SSA, {DestSSAVariableMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_SSA_FIELD, {DestSSAVariableMediumLevelOperandUsage, PartialSSAVariableSourceMediumLevelOperandUsage,
-			OffsetMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_SPLIT_SSA, {HighSSAVariableMediumLevelOperandUsage, LowSSAVariableMediumLevelOperandUsage,
-			SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_ALIASED, {DestSSAVariableMediumLevelOperandUsage, PartialSSAVariableSourceMediumLevelOperandUsage,
-			SourceExprMediumLevelOperandUsage}},
-		{MLIL_SET_VAR_ALIASED_FIELD, {DestSSAVariableMediumLevelOperandUsage, PartialSSAVariableSourceMediumLevelOperandUsage,
-			OffsetMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
-		{MLIL_LOAD, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_LOAD_STRUCT, {SourceExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
-		{MLIL_LOAD_SSA, {SourceExprMediumLevelOperandUsage, SourceMemoryVersionMediumLevelOperandUsage}},
-		{MLIL_LOAD_STRUCT_SSA, {SourceExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
-			SourceMemoryVersionMediumLevelOperandUsage}},
-		{MLIL_STORE, {DestExprMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
-		{MLIL_STORE_STRUCT, {DestExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
-			SourceExprMediumLevelOperandUsage}},
-		{MLIL_STORE_SSA, {DestExprMediumLevelOperandUsage, DestMemoryVersionMediumLevelOperandUsage,
-			SourceMemoryVersionMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
-		{MLIL_STORE_STRUCT_SSA, {DestExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
-			DestMemoryVersionMediumLevelOperandUsage, SourceMemoryVersionMediumLevelOperandUsage,
-			SourceExprMediumLevelOperandUsage}},
-		{MLIL_VAR, {SourceVariableMediumLevelOperandUsage}},
-		{MLIL_VAR_FIELD, {SourceVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
-		{MLIL_VAR_SSA, {SourceSSAVariableMediumLevelOperandUsage}},
-		{MLIL_VAR_SSA_FIELD, {SourceSSAVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
-		{MLIL_VAR_ALIASED, {SourceSSAVariableMediumLevelOperandUsage}},
-		{MLIL_VAR_ALIASED_FIELD, {SourceSSAVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
-		{MLIL_ADDRESS_OF, {SourceVariableMediumLevelOperandUsage}},
-		{MLIL_ADDRESS_OF_FIELD, {SourceVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
-		{MLIL_JUMP, {DestExprMediumLevelOperandUsage}},
-		{MLIL_JUMP_TO, {DestExprMediumLevelOperandUsage, TargetListMediumLevelOperandUsage}},
-		{MLIL_CALL, {OutputVariablesMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
-			ParameterExprsMediumLevelOperandUsage}},
-		{MLIL_CALL_UNTYPED, {OutputVariablesSubExprMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
-			ParameterVariablesMediumLevelOperandUsage}},
-		{MLIL_SYSCALL, {OutputVariablesMediumLevelOperandUsage, ParameterExprsMediumLevelOperandUsage}},
-		{MLIL_SYSCALL_UNTYPED, {OutputVariablesSubExprMediumLevelOperandUsage,
-			ParameterVariablesMediumLevelOperandUsage, StackExprMediumLevelOperandUsage}},
-		{MLIL_CALL_SSA, {OutputSSAVariablesMediumLevelOperandUsage,
-			OutputSSAMemoryVersionMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
-			ParameterExprsMediumLevelOperandUsage, SourceMemoryVersionMediumLevelOperandUsage}},
-		{MLIL_CALL_UNTYPED_SSA, {OutputSSAVariablesMediumLevelOperandUsage,
-			OutputSSAMemoryVersionMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
-			ParameterSSAVariablesMediumLevelOperandUsage, ParameterSSAMemoryVersionMediumLevelOperandUsage,
-			StackExprMediumLevelOperandUsage}},
-		{MLIL_SYSCALL_SSA, {OutputSSAVariablesMediumLevelOperandUsage,
-			OutputSSAMemoryVersionMediumLevelOperandUsage, ParameterExprsMediumLevelOperandUsage,
-			SourceMemoryVersionMediumLevelOperandUsage}},
-		{MLIL_SYSCALL_UNTYPED_SSA, {OutputSSAVariablesMediumLevelOperandUsage,
-			OutputSSAMemoryVersionMediumLevelOperandUsage, ParameterSSAVariablesMediumLevelOperandUsage,
-			ParameterSSAMemoryVersionMediumLevelOperandUsage, StackExprMediumLevelOperandUsage}},
-		{MLIL_RET, {SourceExprsMediumLevelOperandUsage}},
-		{MLIL_IF, {ConditionExprMediumLevelOperandUsage, TrueTargetMediumLevelOperandUsage,
-			FalseTargetMediumLevelOperandUsage}},
-		{MLIL_GOTO, {TargetMediumLevelOperandUsage}},
-		{MLIL_TRAP, {VectorMediumLevelOperandUsage}},
-		{MLIL_VAR_PHI, {DestSSAVariableMediumLevelOperandUsage, SourceSSAVariablesMediumLevelOperandUsages}},
-		{MLIL_MEM_PHI, {DestMemoryVersionMediumLevelOperandUsage, SourceMemoryVersionsMediumLevelOperandUsage}},
-		{MLIL_CONST, {ConstantMediumLevelOperandUsage}},
-		{MLIL_CONST_PTR, {ConstantMediumLevelOperandUsage}},
-		{MLIL_IMPORT, {ConstantMediumLevelOperandUsage}},
-		{MLIL_ADD, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_SUB, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_AND, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_OR, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_XOR, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_LSL, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_LSR, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_ASR, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_ROL, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_ROR, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_MUL, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_MULU_DP, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_MULS_DP, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_DIVU, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_DIVS, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_MODU, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_MODS, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_E, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_NE, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_SLT, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_ULT, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_SLE, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_ULE, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_SGE, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_UGE, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_SGT, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_CMP_UGT, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_TEST_BIT, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_ADD_OVERFLOW, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
-		{MLIL_ADC, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
-			CarryExprMediumLevelOperandUsage}},
-		{MLIL_SBB, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
-			CarryExprMediumLevelOperandUsage}},
-		{MLIL_RLC, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
-			CarryExprMediumLevelOperandUsage}},
-		{MLIL_RRC, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
-			CarryExprMediumLevelOperandUsage}},
-		{MLIL_DIVU_DP, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
-			RightExprMediumLevelOperandUsage}},
-		{MLIL_DIVS_DP, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
-			RightExprMediumLevelOperandUsage}},
-		{MLIL_MODU_DP, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
-			RightExprMediumLevelOperandUsage}},
-		{MLIL_MODS_DP, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
-			RightExprMediumLevelOperandUsage}},
-		{MLIL_NEG, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_NOT, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_SX, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_ZX, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_LOW_PART, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_BOOL_TO_INT, {SourceExprMediumLevelOperandUsage}},
-		{MLIL_UNIMPL_MEM, {SourceExprMediumLevelOperandUsage}}
-	};
+static unordered_map<MediumLevelILOperandUsage, MediumLevelILOperandType> GetOperandTypeForUsages()
+{
+	unordered_map<MediumLevelILOperandUsage, MediumLevelILOperandType> result;
+	for (size_t i = 0; i < MediumLevelILOperandUsageCount; i++)
+		result[(MediumLevelILOperandUsage)i] = MediumLevelILOperandTables::operandTypeForUsage[i];
+	return result;
+}
+
+
+static unordered_map<BNMediumLevelILOperation, vector<MediumLevelILOperandUsage>> GetOperandUsagesForOperations()
+{
+	unordered_map<BNMediumLevelILOperation, vector<MediumLevelILOperandUsage>> result;
+	for (auto& operation : MediumLevelILOperandTables::operationOperandUsage)
+	{
+		if (!operation.valid)
+			continue;
+		result[operation.operation] = vector<MediumLevelILOperandUsage>(operation.usages,
+			operation.usages + operation.count);
+	}
+	return result;
+}
 
 
 static unordered_map<BNMediumLevelILOperation, unordered_map<MediumLevelILOperandUsage, size_t>>
 	GetOperandIndexForOperandUsages()
 {
 	unordered_map<BNMediumLevelILOperation, unordered_map<MediumLevelILOperandUsage, size_t>> result;
-	for (auto& operation : MediumLevelILInstructionBase::operationOperandUsage)
+	for (auto& operation : MediumLevelILOperandTables::operationOperandUsage)
 	{
-		result[operation.first] = unordered_map<MediumLevelILOperandUsage, size_t>();
-
-		size_t operand = 0;
-		for (auto usage : operation.second)
+		if (!operation.valid)
+			continue;
+		unordered_map<MediumLevelILOperandUsage, size_t>& indexMap = result[operation.operation];
+		for (size_t i = 0; i < operation.count; i++)
 		{
-			result[operation.first][usage] = operand;
-			switch (usage)
-			{
-			case PartialSSAVariableSourceMediumLevelOperandUsage:
-				// SSA variables are usually two slots, but this one has a previously defined
-				// variables and thus only takes one slot
-				operand++;
-				break;
-			case OutputVariablesSubExprMediumLevelOperandUsage:
-			case ParameterVariablesMediumLevelOperandUsage:
-				// Represented as subexpression, so only takes one slot even though it is a list
-				operand++;
-				break;
-			case OutputSSAVariablesMediumLevelOperandUsage:
-				// OutputSSAMemoryVersionMediumLevelOperandUsage follows at same operand
-				break;
-			case ParameterSSAVariablesMediumLevelOperandUsage:
-				// ParameterSSAMemoryVersionMediumLevelOperandUsage follows at same operand
-				break;
-			default:
-				switch (MediumLevelILInstructionBase::operandTypeForUsage[usage])
-				{
-				case SSAVariableMediumLevelOperand:
-				case IndexListMediumLevelOperand:
-				case VariableListMediumLevelOperand:
-				case SSAVariableListMediumLevelOperand:
-				case ExprListMediumLevelOperand:
-					// SSA variables and lists take two operand slots
-					operand += 2;
-					break;
-				default:
-					operand++;
-					break;
-				}
-				break;
-			}
+			indexMap[operation.usages[i]] = (size_t)GetMediumLevelILOperandIndex(operation.operation,
+				operation.usages[i]);
 		}
 	}
 	return result;
 }
 
 
+unordered_map<MediumLevelILOperandUsage, MediumLevelILOperandType>
+	MediumLevelILInstructionBase::operandTypeForUsage = GetOperandTypeForUsages();
+unordered_map<BNMediumLevelILOperation, vector<MediumLevelILOperandUsage>>
+	MediumLevelILInstructionBase::operationOperandUsage = GetOperandUsagesForOperations();
 unordered_map<BNMediumLevelILOperation, unordered_map<MediumLevelILOperandUsage, size_t>>
 	MediumLevelILInstructionBase::operationOperandIndex = GetOperandIndexForOperandUsages();
 
@@ -641,10 +466,9 @@ MediumLevelILOperand::MediumLevelILOperand(const MediumLevelILInstruction& instr
 	MediumLevelILOperandUsage usage, size_t operandIndex):
 	m_instr(instr), m_usage(usage), m_operandIndex(operandIndex)
 {
-	auto i = MediumLevelILInstructionBase::operandTypeForUsage.find(m_usage);
-	if (i == MediumLevelILInstructionBase::operandTypeForUsage.end())
+	if ((size_t)m_usage >= MediumLevelILOperandUsageCount)
 		throw MediumLevelILInstructionAccessException();
-	m_type = i->second;
+	m_type = GetMediumLevelILOperandType(m_usage);
 }
 
 
@@ -734,17 +558,15 @@ MediumLevelILInstructionList MediumLevelILOperand::GetExprList() const
 const MediumLevelILOperand MediumLevelILOperandList::ListIterator::operator*()
 {
 	MediumLevelILOperandUsage usage = *pos;
-	auto i = owner->m_operandIndexMap.find(usage);
-	if (i == owner->m_operandIndexMap.end())
+	int operandIndex = GetMediumLevelILOperandIndex(owner->m_instr.operation, usage);
+	if (operandIndex < 0)
 		throw MediumLevelILInstructionAccessException();
-	return MediumLevelILOperand(owner->m_instr, usage, i->second);
+	return MediumLevelILOperand(owner->m_instr, usage, (size_t)operandIndex);
 }
 
 
 MediumLevelILOperandList::MediumLevelILOperandList(const MediumLevelILInstruction& instr,
-	const vector<MediumLevelILOperandUsage>& usageList,
-	const unordered_map<MediumLevelILOperandUsage, size_t>& operandIndexMap):
-	m_instr(instr), m_usageList(usageList), m_operandIndexMap(operandIndexMap)
+	const MediumLevelILOperationOperandUsages& usageList): m_instr(instr), m_usageList(usageList)
 {
 }
 
@@ -753,7 +575,7 @@ MediumLevelILOperandList::const_iterator MediumLevelILOperandList::begin() const
 {
 	const_iterator result;
 	result.owner = this;
-	result.pos = m_usageList.begin();
+	result.pos = m_usageList.usages;
 	return result;
 }
 
@@ -762,24 +584,26 @@ MediumLevelILOperandList::const_iterator MediumLevelILOperandList::end() const
 {
 	const_iterator result;
 	result.owner = this;
-	result.pos = m_usageList.end();
+	result.pos = m_usageList.usages + m_usageList.count;
 	return result;
 }
 
 
 size_t MediumLevelILOperandList::size() const
 {
-	return m_usageList.size();
+	return m_usageList.count;
 }
 
 
 const MediumLevelILOperand MediumLevelILOperandList::operator[](size_t i) const
 {
-	MediumLevelILOperandUsage usage = m_usageList[i];
-	auto indexMap = m_operandIndexMap.find(usage);
-	if (indexMap == m_operandIndexMap.end())
+	if (i >= m_usageList.count)
+		throw MediumLevelILInstructionAccessException();
+	MediumLevelILOperandUsage usage = m_usageList.usages[i];
+	int operandIndex = GetMediumLevelILOperandIndex(m_instr.operation, usage);
+	if (operandIndex < 0)
 		throw MediumLevelILInstructionAccessException();
-	return MediumLevelILOperand(m_instr, usage, indexMap->second);
+	return MediumLevelILOperand(m_instr, usage, (size_t)operandIndex);
 }
 
 
@@ -841,13 +665,10 @@ MediumLevelILInstruction::MediumLevelILInstruction(const MediumLevelILInstructio
 
 MediumLevelILOperandList MediumLevelILInstructionBase::GetOperands() const
 {
-	auto usage = operationOperandUsage.find(operation);
-	if (usage == operationOperandUsage.end())
-		throw MediumLevelILInstructionAccessException();
-	auto operandIndex = operationOperandIndex.find(operation);
-	if (operandIndex == operationOperandIndex.end())
+	if (!IsMediumLevelILOperationValidForOperands(operation))
 		throw MediumLevelILInstructionAccessException();
-	return MediumLevelILOperandList(*(const MediumLevelILInstruction*)this, usage->second, operandIndex->second);
+	return MediumLevelILOperandList(*(const MediumLevelILInstruction*)this,
+		MediumLevelILOperandTables::operationOperandUsage[operation]);
 }
 
 
@@ -1180,77 +1001,82 @@ void MediumLevelILInstructionBase::Replace(ExprId expr)
 
 void MediumLevelILInstruction::VisitExprs(const std::function<bool(const MediumLevelILInstruction& expr)>& func) const
 {
-	if (!func(*this))
-		return;
+	VisitExprTree(func);
+}
+
+
+void MediumLevelILInstruction::GetSubExprs(vector<MediumLevelILInstruction>& exprs) const
+{
+	exprs.clear();
 	switch (operation)
 	{
 	case MLIL_SET_VAR:
-		GetSourceExpr<MLIL_SET_VAR>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR>());
 		break;
 	case MLIL_SET_VAR_SSA:
-		GetSourceExpr<MLIL_SET_VAR_SSA>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_SSA>());
 		break;
 	case MLIL_SET_VAR_ALIASED:
-		GetSourceExpr<MLIL_SET_VAR_ALIASED>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_ALIASED>());
 		break;
 	case MLIL_SET_VAR_SPLIT:
-		GetSourceExpr<MLIL_SET_VAR_SPLIT>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_SPLIT>());
 		break;
 	case MLIL_SET_VAR_SPLIT_SSA:
-		GetSourceExpr<MLIL_SET_VAR_SPLIT_SSA>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_SPLIT_SSA>());
 		break;
 	case MLIL_SET_VAR_FIELD:
-		GetSourceExpr<MLIL_SET_VAR_FIELD>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_FIELD>());
 		break;
 	case MLIL_SET_VAR_SSA_FIELD:
-		GetSourceExpr<MLIL_SET_VAR_SSA_FIELD>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_SSA_FIELD>());
 		break;
 	case MLIL_SET_VAR_ALIASED_FIELD:
-		GetSourceExpr<MLIL_SET_VAR_ALIASED_FIELD>().VisitExprs(func);
+		exprs.push_back(GetSourceExpr<MLIL_SET_VAR_ALIASED_FIELD>());
 		break;
 	case MLIL_CALL:
-		GetDestExpr<MLIL_CALL>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_CALL>());
 		for (auto& i : GetParameterExprs<MLIL_CALL>())
-			i.VisitExprs(func);
+			exprs.push_back(i);
 		break;
 	case MLIL_CALL_UNTYPED:
-		GetDestExpr<MLIL_CALL_UNTYPED>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_CALL_UNTYPED>());
 		break;
 	case MLIL_CALL_SSA:
-		GetDestExpr<MLIL_CALL_SSA>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_CALL_SSA>());
 		for (auto& i : GetParameterExprs<MLIL_CALL_SSA>())
-			i.VisitExprs(func);
+			exprs.push_back(i);
 		break;
 	case MLIL_CALL_UNTYPED_SSA:
-		GetDestExpr<MLIL_CALL_UNTYPED_SSA>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_CALL_UNTYPED_SSA>());
 		break;
 	case MLIL_SYSCALL:
 		for (auto& i : GetParameterExprs<MLIL_SYSCALL>())
-			i.VisitExprs(func);
+			exprs.push_back(i);
 		break;
 	case MLIL_SYSCALL_SSA:
 		for (auto& i : GetParameterExprs<MLIL_SYSCALL_SSA>())
-			i.VisitExprs(func);
+			exprs.push_back(i);
 		break;
 	case MLIL_RET:
 		for (auto& i : GetSourceExprs<MLIL_RET>())
-			i.VisitExprs(func);
+			exprs.push_back(i);
 		break;
 	case MLIL_STORE:
-		GetDestExpr<MLIL_STORE>().VisitExprs(func);
-		GetSourceExpr<MLIL_STORE>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_STORE>());
+		exprs.push_back(GetSourceExpr<MLIL_STORE>());
 		break;
 	case MLIL_STORE_STRUCT:
-		GetDestExpr<MLIL_STORE_STRUCT>().VisitExprs(func);
-		GetSourceExpr<MLIL_STORE_STRUCT>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_STORE_STRUCT>());
+		exprs.push_back(GetSourceExpr<MLIL_STORE_STRUCT>());
 		break;
 	case MLIL_STORE_SSA:
-		GetDestExpr<MLIL_STORE_SSA>().VisitExprs(func);
-		GetSourceExpr<MLIL_STORE_SSA>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_STORE_SSA>());
+		exprs.push_back(GetSourceExpr<MLIL_STORE_SSA>());
 		break;
 	case MLIL_STORE_STRUCT_SSA:
-		GetDestExpr<MLIL_STORE_STRUCT_SSA>().VisitExprs(func);
-		GetSourceExpr<MLIL_STORE_STRUCT_SSA>().VisitExprs(func);
+		exprs.push_back(GetDestExpr<MLIL_STORE_STRUCT_SSA>());
+		exprs.push_back(GetSourceExpr<MLIL_STORE_STRUCT_SSA>());
 		break;
 	case MLIL_NEG:
 	case MLIL_NOT:
@@ -1266,7 +1092,7 @@ void MediumLevelILInstruction::VisitExprs(const std::function<bool(const MediumL
 	case MLIL_LOAD_STRUCT:
 	case MLIL_LOAD_SSA:
 	case MLIL_LOAD_STRUCT_SSA:
-		AsOneOperand().GetSourceExpr().VisitExprs(func);
+		exprs.push_back(AsOneOperand().GetSourceExpr());
 		break;
 	case MLIL_ADD:
 	case MLIL_SUB:
@@ -1297,24 +1123,24 @@ void MediumLevelILInstruction::VisitExprs(const std::function<bool(const MediumL
 	case MLIL_CMP_UGT:
 	case MLIL_TEST_BIT:
 	case MLIL_ADD_OVERFLOW:
-		AsTwoOperand().GetLeftExpr().VisitExprs(func);
-		AsTwoOperand().GetRightExpr().VisitExprs(func);
+		exprs.push_back(AsTwoOperand().GetLeftExpr());
+		exprs.push_back(AsTwoOperand().GetRightExpr());
 		break;
 	case MLIL_ADC:
 	case MLIL_SBB:
 	case MLIL_RLC:
 	case MLIL_RRC:
-		AsTwoOperandWithCarry().GetLeftExpr().VisitExprs(func);
-		AsTwoOperandWithCarry().GetRightExpr().VisitExprs(func);
-		AsTwoOperandWithCarry().GetCarryExpr().VisitExprs(func);
+		exprs.push_back(AsTwoOperandWithCarry().GetLeftExpr());
+		exprs.push_back(AsTwoOperandWithCarry().GetRightExpr());
+		exprs.push_back(AsTwoOperandWithCarry().GetCarryExpr());
 		break;
 	case MLIL_DIVU_DP:
 	case MLIL_DIVS_DP:
 	case MLIL_MODU_DP:
 	case MLIL_MODS_DP:
-		AsDoublePrecision().GetHighExpr().VisitExprs(func);
-		AsDoublePrecision().GetLowExpr().VisitExprs(func);
-		AsDoublePrecision().GetRightExpr().VisitExprs(func);
+		exprs.push_back(AsDoublePrecision().GetHighExpr());
+		exprs.push_back(AsDoublePrecision().GetLowExpr());
+		exprs.push_back(AsDoublePrecision().GetRightExpr());
 		break;
 	default:
 		break;
@@ -1571,13 +1397,10 @@ ExprId MediumLevelILInstruction::CopyTo(MediumLevelILFunction* dest,
 
 bool MediumLevelILInstruction::GetOperandIndexForUsage(MediumLevelILOperandUsage usage, size_t& operandIndex) const
 {
-	auto operationIter = MediumLevelILInstructionBase::operationOperandIndex.find(operation);
-	if (operationIter == MediumLevelILInstructionBase::operationOperandIndex.end())
-		return false;
-	auto usageIter = operationIter->second.find(usage);
-	if (usageIter == operationIter->second.end())
+	int index = GetMediumLevelILOperandIndex(operation, usage);
+	if (index < 0)
 		return false;
-	operandIndex = usageIter->second;
+	operandIndex = (size_t)index;
 	return true;
 }
 
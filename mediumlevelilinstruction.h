@@ -177,6 +177,293 @@ namespace BinaryNinjaCore
 namespace BinaryNinja
 #endif
 {
+	// Dense operand metadata tables. These are indexed directly by operation and operand usage, and can be
+	// used from constexpr context. When adding an operation or operand usage, the counts below must be kept
+	// in sync with the enumerations.
+	constexpr size_t MediumLevelILOperationCount = MLIL_MEM_PHI + 1;
+	constexpr size_t MediumLevelILOperandUsageCount = SourceSSAVariablesMediumLevelOperandUsages + 1;
+	constexpr size_t MediumLevelILMaxOperandUsages = 6;
+
+	struct MediumLevelILOperationOperandUsages
+	{
+		BNMediumLevelILOperation operation;
+		bool valid;
+		size_t count;
+		MediumLevelILOperandUsage usages[MediumLevelILMaxOperandUsages];
+	};
+
+	struct MediumLevelILOperandIndexRow
+	{
+		int8_t index[MediumLevelILOperandUsageCount];
+	};
+
+	template <size_t... N> struct MediumLevelILIndexSequence {};
+	template <size_t N, size_t... S> struct MediumLevelILMakeIndexSequence:
+		MediumLevelILMakeIndexSequence<N - 1, N - 1, S...> {};
+	template <size_t... S> struct MediumLevelILMakeIndexSequence<0, S...>
+	{
+		typedef MediumLevelILIndexSequence<S...> Type;
+	};
+
+	struct MediumLevelILOperandTables
+	{
+		static constexpr MediumLevelILOperandType operandTypeForUsage[MediumLevelILOperandUsageCount] = {
+			ExprMediumLevelOperand, // SourceExprMediumLevelOperandUsage
+			VariableMediumLevelOperand, // SourceVariableMediumLevelOperandUsage
+			SSAVariableMediumLevelOperand, // SourceSSAVariableMediumLevelOperandUsage
+			SSAVariableMediumLevelOperand, // PartialSSAVariableSourceMediumLevelOperandUsage
+			ExprMediumLevelOperand, // DestExprMediumLevelOperandUsage
+			VariableMediumLevelOperand, // DestVariableMediumLevelOperandUsage
+			SSAVariableMediumLevelOperand, // DestSSAVariableMediumLevelOperandUsage
+			ExprMediumLevelOperand, // LeftExprMediumLevelOperandUsage
+			ExprMediumLevelOperand, // RightExprMediumLevelOperandUsage
+			ExprMediumLevelOperand, // CarryExprMediumLevelOperandUsage
+			ExprMediumLevelOperand, // HighExprMediumLevelOperandUsage
+			ExprMediumLevelOperand, // LowExprMediumLevelOperandUsage
+			ExprMediumLevelOperand, // StackExprMediumLevelOperandUsage
+			ExprMediumLevelOperand, // ConditionExprMediumLevelOperandUsage
+			VariableMediumLevelOperand, // HighVariableMediumLevelOperandUsage
+			VariableMediumLevelOperand, // LowVariableMediumLevelOperandUsage
+			VariableMediumLevelOperand, // HighSSAVariableMediumLevelOperandUsage
+			VariableMediumLevelOperand, // LowSSAVariableMediumLevelOperandUsage
+			IntegerMediumLevelOperand, // OffsetMediumLevelOperandUsage
+			IntegerMediumLevelOperand, // ConstantMediumLevelOperandUsage
+			IntegerMediumLevelOperand, // VectorMediumLevelOperandUsage
+			IndexMediumLevelOperand, // TargetMediumLevelOperandUsage
+			IndexMediumLevelOperand, // TrueTargetMediumLevelOperandUsage
+			IndexMediumLevelOperand, // FalseTargetMediumLevelOperandUsage
+			IndexMediumLevelOperand, // DestMemoryVersionMediumLevelOperandUsage
+			IndexMediumLevelOperand, // SourceMemoryVersionMediumLevelOperandUsage
+			IndexListMediumLevelOperand, // TargetListMediumLevelOperandUsage
+			IndexListMediumLevelOperand, // SourceMemoryVersionsMediumLevelOperandUsage
+			VariableListMediumLevelOperand, // OutputVariablesMediumLevelOperandUsage
+			VariableListMediumLevelOperand, // OutputVariablesSubExprMediumLevelOperandUsage
+			SSAVariableListMediumLevelOperand, // OutputSSAVariablesMediumLevelOperandUsage
+			IndexMediumLevelOperand, // OutputSSAMemoryVersionMediumLevelOperandUsage
+			ExprListMediumLevelOperand, // ParameterExprsMediumLevelOperandUsage
+			ExprListMediumLevelOperand, // SourceExprsMediumLevelOperandUsage
+			VariableListMediumLevelOperand, // ParameterVariablesMediumLevelOperandUsage
+			SSAVariableListMediumLevelOperand, // ParameterSSAVariablesMediumLevelOperandUsage
+			IndexMediumLevelOperand, // ParameterSSAMemoryVersionMediumLevelOperandUsage
+			SSAVariableListMediumLevelOperand // SourceSSAVariablesMediumLevelOperandUsages
+		};
+
+		// Ordered by operation, operations without an entry are not valid for operand access
+		static constexpr MediumLevelILOperationOperandUsages operationOperandUsage[MediumLevelILOperationCount] = {
+			{MLIL_NOP, true, 0, {}},
+			{MLIL_SET_VAR, true, 2, {DestVariableMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_FIELD, true, 3, {DestVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
+				SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_SPLIT, true, 3, {HighVariableMediumLevelOperandUsage,
+				LowVariableMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
+			{MLIL_LOAD, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_LOAD_STRUCT, true, 2, {SourceExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
+			{MLIL_STORE, true, 2, {DestExprMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
+			{MLIL_STORE_STRUCT, true, 3, {DestExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
+				SourceExprMediumLevelOperandUsage}},
+			{MLIL_VAR, true, 1, {SourceVariableMediumLevelOperandUsage}},
+			{MLIL_VAR_FIELD, true, 2, {SourceVariableMediumLevelOperandUsage, OffsetMediumLevelOperandUsage}},
+			{MLIL_ADDRESS_OF, true, 1, {SourceVariableMediumLevelOperandUsage}},
+			{MLIL_ADDRESS_OF_FIELD, true, 2, {SourceVariableMediumLevelOperandUsage,
+				OffsetMediumLevelOperandUsage}},
+			{MLIL_CONST, true, 1, {ConstantMediumLevelOperandUsage}},
+			{MLIL_CONST_PTR, true, 1, {ConstantMediumLevelOperandUsage}},
+			{MLIL_IMPORT, true, 1, {ConstantMediumLevelOperandUsage}},
+			{MLIL_ADD, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_ADC, true, 3, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
+				CarryExprMediumLevelOperandUsage}},
+			{MLIL_SUB, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_SBB, true, 3, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
+				CarryExprMediumLevelOperandUsage}},
+			{MLIL_AND, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_OR, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_XOR, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_LSL, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_LSR, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_ASR, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_ROL, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_RLC, true, 3, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
+				CarryExprMediumLevelOperandUsage}},
+			{MLIL_ROR, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_RRC, true, 3, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage,
+				CarryExprMediumLevelOperandUsage}},
+			{MLIL_MUL, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_MULU_DP, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_MULS_DP, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_DIVU, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_DIVU_DP, true, 3, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
+				RightExprMediumLevelOperandUsage}},
+			{MLIL_DIVS, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_DIVS_DP, true, 3, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
+				RightExprMediumLevelOperandUsage}},
+			{MLIL_MODU, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_MODU_DP, true, 3, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
+				RightExprMediumLevelOperandUsage}},
+			{MLIL_MODS, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_MODS_DP, true, 3, {HighExprMediumLevelOperandUsage, LowExprMediumLevelOperandUsage,
+				RightExprMediumLevelOperandUsage}},
+			{MLIL_NEG, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_NOT, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_SX, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_ZX, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_LOW_PART, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_JUMP, true, 1, {DestExprMediumLevelOperandUsage}},
+			{MLIL_JUMP_TO, true, 2, {DestExprMediumLevelOperandUsage, TargetListMediumLevelOperandUsage}},
+			{MLIL_CALL, true, 3, {OutputVariablesMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
+				ParameterExprsMediumLevelOperandUsage}},
+			{MLIL_CALL_UNTYPED, true, 3, {OutputVariablesSubExprMediumLevelOperandUsage,
+				DestExprMediumLevelOperandUsage, ParameterVariablesMediumLevelOperandUsage}},
+			{MLIL_CALL_OUTPUT, false, 0, {}},
+			{MLIL_CALL_PARAM, false, 0, {}},
+			{MLIL_RET, true, 1, {SourceExprsMediumLevelOperandUsage}},
+			{MLIL_NORET, true, 0, {}},
+			{MLIL_IF, true, 3, {ConditionExprMediumLevelOperandUsage, TrueTargetMediumLevelOperandUsage,
+				FalseTargetMediumLevelOperandUsage}},
+			{MLIL_GOTO, true, 1, {TargetMediumLevelOperandUsage}},
+			{MLIL_CMP_E, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_NE, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_SLT, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_ULT, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_SLE, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_ULE, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_SGE, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_UGE, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_SGT, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_CMP_UGT, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_TEST_BIT, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_BOOL_TO_INT, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_ADD_OVERFLOW, true, 2, {LeftExprMediumLevelOperandUsage, RightExprMediumLevelOperandUsage}},
+			{MLIL_SYSCALL, true, 2, {OutputVariablesMediumLevelOperandUsage,
+				ParameterExprsMediumLevelOperandUsage}},
+			{MLIL_SYSCALL_UNTYPED, true, 3, {OutputVariablesSubExprMediumLevelOperandUsage,
+				ParameterVariablesMediumLevelOperandUsage, StackExprMediumLevelOperandUsage}},
+			{MLIL_BP, true, 0, {}},
+			{MLIL_TRAP, true, 1, {VectorMediumLevelOperandUsage}},
+			{MLIL_UNDEF, true, 0, {}},
+			{MLIL_UNIMPL, true, 0, {}},
+			{MLIL_UNIMPL_MEM, true, 1, {SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_SSA, true, 2, {DestSSAVariableMediumLevelOperandUsage,
+				SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_SSA_FIELD, true, 4, {DestSSAVariableMediumLevelOperandUsage,
+				PartialSSAVariableSourceMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
+				SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_SPLIT_SSA, true, 3, {HighSSAVariableMediumLevelOperandUsage,
+				LowSSAVariableMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_ALIASED, true, 3, {DestSSAVariableMediumLevelOperandUsage,
+				PartialSSAVariableSourceMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
+			{MLIL_SET_VAR_ALIASED_FIELD, true, 4, {DestSSAVariableMediumLevelOperandUsage,
+				PartialSSAVariableSourceMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
+				SourceExprMediumLevelOperandUsage}},
+			{MLIL_VAR_SSA, true, 1, {SourceSSAVariableMediumLevelOperandUsage}},
+			{MLIL_VAR_SSA_FIELD, true, 2, {SourceSSAVariableMediumLevelOperandUsage,
+				OffsetMediumLevelOperandUsage}},
+			{MLIL_VAR_ALIASED, true, 1, {SourceSSAVariableMediumLevelOperandUsage}},
+			{MLIL_VAR_ALIASED_FIELD, true, 2, {SourceSSAVariableMediumLevelOperandUsage,
+				OffsetMediumLevelOperandUsage}},
+			{MLIL_CALL_SSA, true, 5, {OutputSSAVariablesMediumLevelOperandUsage,
+				OutputSSAMemoryVersionMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
+				ParameterExprsMediumLevelOperandUsage, SourceMemoryVersionMediumLevelOperandUsage}},
+			{MLIL_CALL_UNTYPED_SSA, true, 6, {OutputSSAVariablesMediumLevelOperandUsage,
+				OutputSSAMemoryVersionMediumLevelOperandUsage, DestExprMediumLevelOperandUsage,
+				ParameterSSAVariablesMediumLevelOperandUsage, ParameterSSAMemoryVersionMediumLevelOperandUsage,
+				StackExprMediumLevelOperandUsage}},
+			{MLIL_SYSCALL_SSA, true, 4, {OutputSSAVariablesMediumLevelOperandUsage,
+				OutputSSAMemoryVersionMediumLevelOperandUsage, ParameterExprsMediumLevelOperandUsage,
+				SourceMemoryVersionMediumLevelOperandUsage}},
+			{MLIL_SYSCALL_UNTYPED_SSA, true, 5, {OutputSSAVariablesMediumLevelOperandUsage,
+				OutputSSAMemoryVersionMediumLevelOperandUsage, ParameterSSAVariablesMediumLevelOperandUsage,
+				ParameterSSAMemoryVersionMediumLevelOperandUsage, StackExprMediumLevelOperandUsage}},
+			{MLIL_CALL_PARAM_SSA, false, 0, {}},
+			{MLIL_CALL_OUTPUT_SSA, false, 0, {}},
+			{MLIL_LOAD_SSA, true, 2, {SourceExprMediumLevelOperandUsage,
+				SourceMemoryVersionMediumLevelOperandUsage}},
+			{MLIL_LOAD_STRUCT_SSA, true, 3, {SourceExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
+				SourceMemoryVersionMediumLevelOperandUsage}},
+			{MLIL_STORE_SSA, true, 4, {DestExprMediumLevelOperandUsage, DestMemoryVersionMediumLevelOperandUsage,
+				SourceMemoryVersionMediumLevelOperandUsage, SourceExprMediumLevelOperandUsage}},
+			{MLIL_STORE_STRUCT_SSA, true, 5, {DestExprMediumLevelOperandUsage, OffsetMediumLevelOperandUsage,
+				DestMemoryVersionMediumLevelOperandUsage, SourceMemoryVersionMediumLevelOperandUsage,
+				SourceExprMediumLevelOperandUsage}},
+			{MLIL_VAR_PHI, true, 2, {DestSSAVariableMediumLevelOperandUsage,
+				SourceSSAVariablesMediumLevelOperandUsages}},
+			{MLIL_MEM_PHI, true, 2, {DestMemoryVersionMediumLevelOperandUsage,
+				SourceMemoryVersionsMediumLevelOperandUsage}}
+		};
+
+		static constexpr bool IsOrdered(size_t i = 0)
+		{
+			return (i >= MediumLevelILOperationCount) ||
+				(((size_t)operationOperandUsage[i].operation == i) && IsOrdered(i + 1));
+		}
+
+		static constexpr size_t GetOperandSlotCount(MediumLevelILOperandUsage usage)
+		{
+			// SSA variables and lists take two operand slots, except for those represented as a subexpression
+			// or referring to a previously defined variable, which take one, and those followed by a memory
+			// version at the same operand
+			return ((usage == PartialSSAVariableSourceMediumLevelOperandUsage) ||
+				(usage == OutputVariablesSubExprMediumLevelOperandUsage) ||
+				(usage == ParameterVariablesMediumLevelOperandUsage)) ? 1 :
+				((usage == OutputSSAVariablesMediumLevelOperandUsage) ||
+				(usage == ParameterSSAVariablesMediumLevelOperandUsage)) ? 0 :
+				((operandTypeForUsage[usage] == SSAVariableMediumLevelOperand) ||
+				(operandTypeForUsage[usage] == IndexListMediumLevelOperand) ||
+				(operandTypeForUsage[usage] == VariableListMediumLevelOperand) ||
+				(operandTypeForUsage[usage] == SSAVariableListMediumLevelOperand) ||
+				(operandTypeForUsage[usage] == ExprListMediumLevelOperand)) ? 2 : 1;
+		}
+
+		static constexpr int8_t ComputeOperandIndex(const MediumLevelILOperationOperandUsages& operation,
+			MediumLevelILOperandUsage usage, size_t i = 0, size_t slot = 0)
+		{
+			return (i >= operation.count) ? -1 : (operation.usages[i] == usage) ? (int8_t)slot :
+				ComputeOperandIndex(operation, usage, i + 1, slot + GetOperandSlotCount(operation.usages[i]));
+		}
+
+		template <size_t... Usage>
+		static constexpr MediumLevelILOperandIndexRow ComputeOperandIndexRow(size_t operation,
+			MediumLevelILIndexSequence<Usage...>)
+		{
+			return MediumLevelILOperandIndexRow{{ComputeOperandIndex(operationOperandUsage[operation],
+				(MediumLevelILOperandUsage)Usage)...}};
+		}
+	};
+
+	static_assert(MediumLevelILOperandTables::IsOrdered(), "MLIL operand usage table must be ordered by operation");
+
+	template <typename Operations> struct MediumLevelILOperandIndexTable;
+	template <size_t... Operation> struct MediumLevelILOperandIndexTable<MediumLevelILIndexSequence<Operation...>>
+	{
+		static constexpr MediumLevelILOperandIndexRow rows[sizeof...(Operation)] = {
+			MediumLevelILOperandTables::ComputeOperandIndexRow(Operation,
+				MediumLevelILMakeIndexSequence<MediumLevelILOperandUsageCount>::Type())...
+		};
+	};
+
+	template <size_t... Operation> constexpr MediumLevelILOperandIndexRow
+		MediumLevelILOperandIndexTable<MediumLevelILIndexSequence<Operation...>>::rows[sizeof...(Operation)];
+
+	typedef MediumLevelILOperandIndexTable<MediumLevelILMakeIndexSequence<MediumLevelILOperationCount>::Type>
+		MediumLevelILOperandIndices;
+
+	constexpr bool IsMediumLevelILOperationValidForOperands(BNMediumLevelILOperation operation)
+	{
+		return ((size_t)operation < MediumLevelILOperationCount) &&
+			MediumLevelILOperandTables::operationOperandUsage[operation].valid;
+	}
+
+	constexpr MediumLevelILOperandType GetMediumLevelILOperandType(MediumLevelILOperandUsage usage)
+	{
+		return MediumLevelILOperandTables::operandTypeForUsage[usage];
+	}
+
+	// Returns the operand index for the given usage, or -1 if the operation does not have that operand
+	constexpr int GetMediumLevelILOperandIndex(BNMediumLevelILOperation operation, MediumLevelILOperandUsage usage)
+	{
+		return (((size_t)operation < MediumLevelILOperationCount) && ((size_t)usage < MediumLevelILOperandUsageCount)) ?
+			MediumLevelILOperandIndices::rows[operation].index[usage] : -1;
+	}
+
 	class MediumLevelILInstructionAccessException: public std::exception
 	{
 	public:
@@ -471,6 +758,15 @@ namespace BinaryNinja
 
 		void VisitExprs(const std::function<bool(const MediumLevelILInstruction& expr)>& func) const;
 
+		// Walks the expression tree with an explicit stack instead of recursion, so arbitrarily deep expressions
+		// can be visited. The pre-order callback returns false to skip the subexpressions of the expression
+		// it was given; the post-order callback is called once all subexpressions have been visited and is not
+		// called for skipped expressions.
+		template <typename PreFunc> void VisitExprTree(const PreFunc& preOrder) const;
+		template <typename PreFunc, typename PostFunc>
+		void VisitExprTree(const PreFunc& preOrder, const PostFunc& postOrder) const;
+		void GetSubExprs(std::vector<MediumLevelILInstruction>& exprs) const;
+
 		ExprId CopyTo(MediumLevelILFunction* dest) const;
 		ExprId CopyTo(MediumLevelILFunction* dest,
 			const std::function<ExprId(const MediumLevelILInstruction& subExpr)>& subExprHandler) const;
@@ -594,7 +890,7 @@ namespace BinaryNinja
 		struct ListIterator
 		{
 			const MediumLevelILOperandList* owner;
-			std::vector<MediumLevelILOperandUsage>::const_iterator pos;
+			const MediumLevelILOperandUsage* pos;
 			bool operator==(const ListIterator& a) const { return pos == a.pos; }
 			bool operator!=(const ListIterator& a) const { return pos != a.pos; }
 			bool operator<(const ListIterator& a) const { return pos < a.pos; }
@@ -603,15 +899,13 @@ namespace BinaryNinja
 		};
 
 		MediumLevelILInstruction m_instr;
-		const std::vector<MediumLevelILOperandUsage>& m_usageList;
-		const std::unordered_map<MediumLevelILOperandUsage, size_t>& m_operandIndexMap;
+		const MediumLevelILOperationOperandUsages& m_usageList;
 
 	public:
 		typedef ListIterator const_iterator;
 
 		MediumLevelILOperandList(const MediumLevelILInstruction& instr,
-			const std::vector<MediumLevelILOperandUsage>& usageList,
-			const std::unordered_map<MediumLevelILOperandUsage, size_t>& operandIndexMap);
+			const MediumLevelILOperationOperandUsages& usageList);
 
 		const_iterator begin() const;
 		const_iterator end() const;
@@ -983,4 +1277,40 @@ namespace BinaryNinja
 	template <> struct MediumLevelILInstructionAccessor<MLIL_LOW_PART>: public MediumLevelILOneOperandInstruction {};
 	template <> struct MediumLevelILInstructionAccessor<MLIL_BOOL_TO_INT>: public MediumLevelILOneOperandInstruction {};
 	template <> struct MediumLevelILInstructionAccessor<MLIL_UNIMPL_MEM>: public MediumLevelILOneOperandInstruction {};
+
+	template <typename PreFunc>
+	void MediumLevelILInstruction::VisitExprTree(const PreFunc& preOrder) const
+	{
+		VisitExprTree(preOrder, [](const MediumLevelILInstruction&) {});
+	}
+
+	template <typename PreFunc, typename PostFunc>
+	void MediumLevelILInstruction::VisitExprTree(const PreFunc& preOrder, const PostFunc& postOrder) const
+	{
+		// Each stack entry holds an expression and whether its subexpressions have already been pushed
+		std::vector<std::pair<MediumLevelILInstruction, bool>> stack;
+		std::vector<MediumLevelILInstruction> subExprs;
+		stack.push_back(std::make_pair(*this, false));
+		while (!stack.empty())
+		{
+			if (stack.back().second)
+			{
+				postOrder(stack.back().first);
+				stack.pop_back();
+				continue;
+			}
+
+			if (!preOrder(stack.back().first))
+			{
+				stack.pop_back();
+				continue;
+			}
+
+			stack.back().second = true;
+			stack.back().first.GetSubExprs(subExprs);
+			// Move the subexpressions onto the stack so that visiting does not take extra function references
+			for (auto i = subExprs.rbegin(); i != subExprs.rend(); ++i)
+				stack.emplace_back(std::move(*i), false);
+		}
+	}
 }
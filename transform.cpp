@@ -67,15 +67,54 @@ void Transform::FreeParametersCallback(BNTransformParameterInfo* params, size_t
 }
 
 
+namespace
+{
+	// Wraps core owned buffers in DataBuffer objects for the duration of a callback. The wrappers are
+	// detached when the guard goes out of scope, including when the callback throws, so the core buffers
+	// are never freed here.
+	class BorrowedBuffers
+	{
+		DataBuffer& m_input;
+		map<string, DataBuffer>& m_params;
+
+	public:
+		BorrowedBuffers(DataBuffer& input, map<string, DataBuffer>& params): m_input(input), m_params(params) {}
+
+		~BorrowedBuffers()
+		{
+			m_input.DetachBufferObject();
+			for (auto& i : m_params)
+				i.second.DetachBufferObject();
+		}
+
+		void Borrow(BNDataBuffer* input, BNTransformParameter* params, size_t paramCount)
+		{
+			m_input = DataBuffer(input);
+			for (size_t i = 0; i < paramCount; i++)
+			{
+				// Insert an empty wrapper first, so that a borrowed buffer is never held by a temporary that
+				// could be destroyed. A repeated name replaces the earlier value.
+				auto param = m_params.find(params[i].name);
+				if (param == m_params.end())
+					param = m_params.insert(make_pair(string(params[i].name), DataBuffer((BNDataBuffer*)nullptr))).first;
+				param->second.DetachBufferObject();
+				param->second = DataBuffer(params[i].value);
+			}
+		}
+	};
+}
+
+
 bool Transform::DecodeCallback(void* ctxt, BNDataBuffer* input, BNDataBuffer* output, BNTransformParameter* params, size_t paramCount)
 {
+	// The input and parameters are only exposed as const references, so borrow the core buffers
+	// instead of duplicating them
+	DataBuffer inputBuf((BNDataBuffer*)nullptr);
 	map<string, DataBuffer> paramMap;
-	for (size_t i = 0; i < paramCount; i++)
-		paramMap[params[i].name] = DataBuffer(BNDuplicateDataBuffer(params[i].value));
+	BorrowedBuffers borrowed(inputBuf, paramMap);
+	borrowed.Borrow(input, params, paramCount);
 
-	DataBuffer inputBuf(BNDuplicateDataBuffer(input));
 	DataBuffer outputBuf;
-
 	Transform* xform = (Transform*)ctxt;
 	bool result = xform->Decode(inputBuf, outputBuf, paramMap);
 	BNAssignDataBuffer(output, outputBuf.GetBufferObject());
@@ -85,13 +124,14 @@ bool Transform::DecodeCallback(void* ctxt, BNDataBuffer* input, BNDataBuffer* ou
 
 bool Transform::EncodeCallback(void* ctxt, BNDataBuffer* input, BNDataBuffer* output, BNTransformParameter* params, size_t paramCount)
 {
+	// The input and parameters are only exposed as const references, so borrow the core buffers
+	// instead of duplicating them
+	DataBuffer inputBuf((BNDataBuffer*)nullptr);
 	map<string, DataBuffer> paramMap;
-	for (size_t i = 0; i < paramCount; i++)
-		paramMap[params[i].name] = DataBuffer(BNDuplicateDataBuffer(params[i].value));
+	BorrowedBuffers borrowed(inputBuf, paramMap);
+	borrowed.Borrow(input, params, paramCount);
 
-	DataBuffer inputBuf(BNDuplicateDataBuffer(input));
 	DataBuffer outputBuf;
-
 	Transform* xform = (Transform*)ctxt;
 	bool result = xform->Encode(inputBuf, outputBuf, paramMap);
 	BNAssignDataBuffer(output, outputBuf.GetBufferObject());
@@ -473,20 +473,7 @@ vector<InstructionTextToken> Type::GetTokens(Platform* platform, uint8_t baseCon
 	BNInstructionTextToken* tokens = BNGetTypeTokens(m_object,
 		platform ? platform->GetObject() : nullptr, baseConfidence, &count);
 
-	vector<InstructionTextToken> result;
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = tokens[i].type;
-		token.text = tokens[i].text;
-		token.value = tokens[i].value;
-		token.size = tokens[i].size;
-		token.operand = tokens[i].operand;
-		token.context = tokens[i].context;
-		token.confidence = tokens[i].confidence;
-		token.address = tokens[i].address;
-		result.push_back(token);
-	}
+	vector<InstructionTextToken> result = InstructionTextToken::ConvertInstructionTextTokenList(tokens, count);
 
 	BNFreeTokenList(tokens, count);
 	return result;
@@ -499,20 +486,7 @@ vector<InstructionTextToken> Type::GetTokensBeforeName(Platform* platform, uint8
 	BNInstructionTextToken* tokens = BNGetTypeTokensBeforeName(m_object,
 		platform ? platform->GetObject() : nullptr, baseConfidence, &count);
 
-	vector<InstructionTextToken> result;
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = tokens[i].type;
-		token.text = tokens[i].text;
-		token.value = tokens[i].value;
-		token.size = tokens[i].size;
-		token.operand = tokens[i].operand;
-		token.context = tokens[i].context;
-		token.confidence = tokens[i].confidence;
-		token.address = tokens[i].address;
-		result.push_back(token);
-	}
+	vector<InstructionTextToken> result = InstructionTextToken::ConvertInstructionTextTokenList(tokens, count);
 
 	BNFreeTokenList(tokens, count);
 	return result;
@@ -525,20 +499,7 @@ vector<InstructionTextToken> Type::GetTokensAfterName(Platform* platform, uint8_
 	BNInstructionTextToken* tokens = BNGetTypeTokensAfterName(m_object,
 		platform ? platform->GetObject() : nullptr, baseConfidence, &count);
 
-	vector<InstructionTextToken> result;
-	for (size_t i = 0; i < count; i++)
-	{
-		InstructionTextToken token;
-		token.type = tokens[i].type;
-		token.text = tokens[i].text;
-		token.value = tokens[i].value;
-		token.size = tokens[i].size;
-		token.operand = tokens[i].operand;
-		token.context = tokens[i].context;
-		token.confidence = tokens[i].confidence;
-		token.address = tokens[i].address;
-		result.push_back(token);
-	}
+	vector<InstructionTextToken> result = InstructionTextToken::ConvertInstructionTextTokenList(tokens, count);
 
 	BNFreeTokenList(tokens, count);
 	return result;